@@ -0,0 +1,244 @@
+#include "PluginProcessor.h"
+#include "catch2/benchmark/catch_benchmark_all.hpp"
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/generators/catch_generators.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+// processBlock throughput per processing mode.
+//
+// Every sweep registers one Catch2 benchmark per configuration (the numbers to
+// watch for regressions), then times a longer uninterrupted run of the same
+// configuration and prints ns per sample frame and the real-time factor, i.e.
+// how many seconds of audio one core renders per second. Those are the numbers
+// used to size how many instances fit on a machine.
+//
+// Run a single sweep with e.g. `Benchmarks "[throughput][blockSize]"`.
+
+namespace
+{
+    constexpr int numProcessingModes = SignalPathManager::SendReturn + 1;
+
+    const char* getModeName (int mode)
+    {
+        static constexpr const char* names[] = { "DelayOnly", "ReverbOnly", "GranularOnly", "LooperOnly", "Serial", "Parallel", "SendReturn" };
+        static_assert (std::size (names) == numProcessingModes);
+        return names[mode];
+    }
+
+    struct ThroughputConfig
+    {
+        int mode = SignalPathManager::Serial;
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+        int numChannels = 2;
+        float grainDensity = 5.0f;  // grains per second
+        float grainSize = 0.5f;     // seconds
+        int grainQuality = Interpolation::Hermite;
+        int numWorkerThreads = 0;   // parallel branch workers, see SignalPathManager
+
+        // kernel instruction set to force, numIsas leaves the best one
+        KernelDispatch::Isa isa = KernelDispatch::numIsas;
+
+        [[nodiscard]] std::string getName() const
+        {
+            std::ostringstream name;
+            name << getModeName (mode) << " " << sampleRate / 1000.0 << "kHz "
+                 << blockSize << " samples " << (numChannels == 1 ? "mono" : "stereo");
+            if (mode == SignalPathManager::GranularOnly || mode >= SignalPathManager::Serial)
+                name << " density " << grainDensity << "/s";
+            if (numWorkerThreads > 0)
+                name << " " << numWorkerThreads << " workers";
+            if (isa != KernelDispatch::numIsas)
+                name << " quality " << grainQuality << " " << KernelDispatch::getIsaName (isa);
+            return name.str();
+        }
+    };
+
+    void setParameter (PluginProcessor& plugin, const juce::String& id, float value)
+    {
+        auto* parameter = plugin.apvts.getParameter (id);
+        REQUIRE (parameter != nullptr);
+        parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+    }
+
+    // a prepared plugin plus the buffers to drive it, already past its warm-up
+    // (grain pool filled up, looper holding a loop) so timings are steady-state
+    class ThroughputRig
+    {
+    public:
+        explicit ThroughputRig (const ThroughputConfig& configToUse)
+            : config (configToUse),
+              input (config.numChannels, config.blockSize),
+              buffer (config.numChannels, config.blockSize)
+        {
+            const auto channelSet = config.numChannels == 1 ? juce::AudioChannelSet::mono()
+                                                            : juce::AudioChannelSet::stereo();
+            juce::AudioProcessor::BusesLayout layout;
+            layout.inputBuses.add (channelSet);
+            layout.outputBuses.add (channelSet);
+            REQUIRE (plugin.setBusesLayout (layout));
+
+            setParameter (plugin, "signalPath", static_cast<float> (config.mode));
+            setParameter (plugin, "grainDensity", config.grainDensity);
+            setParameter (plugin, "grainSize", config.grainSize);
+            setParameter (plugin, "grainQuality", static_cast<float> (config.grainQuality));
+
+            // the kernels are picked in prepare
+            if (config.isa != KernelDispatch::numIsas)
+                KernelDispatch::setIsaOverride (config.isa);
+            else
+                KernelDispatch::clearIsaOverride();
+
+            plugin.setNumWorkerThreads (config.numWorkerThreads);
+            plugin.prepareToPlay (config.sampleRate, config.blockSize);
+
+            juce::Random random (config.blockSize);
+            for (int channel = 0; channel < input.getNumChannels(); ++channel)
+                for (int i = 0; i < input.getNumSamples(); ++i)
+                    input.setSample (channel, i, random.nextFloat() * 0.5f - 0.25f);
+
+            // the looper is measured overdubbing, its most expensive state,
+            // over a one second loop
+            if (config.mode == SignalPathManager::LooperOnly || config.mode >= SignalPathManager::Serial)
+            {
+                setParameter (plugin, "looperState", static_cast<float> (LooperProcessor::Recording));
+                processSeconds (1.0);
+                setParameter (plugin, "looperState", static_cast<float> (LooperProcessor::Overdubbing));
+            }
+
+            // let the grain pool reach its steady-state population
+            processSeconds (static_cast<double> (config.grainSize) + 0.1);
+        }
+
+        void processBlock()
+        {
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                buffer.copyFrom (channel, 0, input, channel, 0, config.blockSize);
+
+            plugin.processBlock (buffer, midi);
+        }
+
+        void processSeconds (double seconds)
+        {
+            const auto numBlocks = juce::jmax (1, static_cast<int> (seconds * config.sampleRate / config.blockSize));
+            for (int block = 0; block < numBlocks; ++block)
+                processBlock();
+        }
+
+        // times `seconds` of audio in one go and prints the throughput
+        void report (double seconds)
+        {
+            const auto numBlocks = juce::jmax (1, static_cast<int> (seconds * config.sampleRate / config.blockSize));
+
+            const auto start = std::chrono::steady_clock::now();
+            for (int block = 0; block < numBlocks; ++block)
+                processBlock();
+            const auto elapsed = std::chrono::duration<double, std::nano> (std::chrono::steady_clock::now() - start);
+
+            const auto numFrames = static_cast<double> (numBlocks) * config.blockSize;
+            const auto nsPerSample = elapsed.count() / numFrames;
+            const auto realtimeFactor = (1.0e9 / config.sampleRate) / nsPerSample;
+
+            std::cout << std::left << std::setw (60) << config.getName()
+                      << std::right << std::fixed << std::setprecision (2)
+                      << std::setw (10) << nsPerSample << " ns/sample"
+                      << std::setw (12) << std::setprecision (1) << realtimeFactor << "x real time\n";
+        }
+
+        const ThroughputConfig config;
+
+    private:
+        PluginProcessor plugin;
+        juce::AudioBuffer<float> input, buffer;
+        juce::MidiBuffer midi;
+    };
+
+    void runThroughput (const ThroughputConfig& config)
+    {
+        ThroughputRig rig (config);
+
+        BENCHMARK (config.getName() + " (one block)")
+        {
+            rig.processBlock();
+        };
+
+        rig.report (2.0);
+    }
+}
+
+TEST_CASE ("Processing throughput by block size", "[throughput][blockSize]")
+{
+    ThroughputConfig config;
+    config.mode = GENERATE (range (0, numProcessingModes));
+    config.blockSize = GENERATE (32, 64, 128, 256, 512, 1024, 2048, 4096);
+
+    runThroughput (config);
+}
+
+TEST_CASE ("Processing throughput by sample rate", "[throughput][sampleRate]")
+{
+    ThroughputConfig config;
+    config.mode = GENERATE (range (0, numProcessingModes));
+    config.sampleRate = GENERATE (44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0);
+
+    runThroughput (config);
+}
+
+TEST_CASE ("Processing throughput mono vs stereo", "[throughput][channels]")
+{
+    // the delay and granular processors pick a mono or stereo kernel once per
+    // block, so mono should cost close to half of stereo in those modes
+    ThroughputConfig config;
+    config.mode = GENERATE (range (0, numProcessingModes));
+    config.numChannels = GENERATE (1, 2);
+
+    runThroughput (config);
+}
+
+TEST_CASE ("Granular throughput by grain density", "[throughput][granular]")
+{
+    // with 2 s grains the average number of overlapping grains is twice the
+    // density, so this sweeps from a handful of voices up to ~20
+    ThroughputConfig config;
+    config.mode = SignalPathManager::GranularOnly;
+    config.grainSize = 2.0f;
+    config.grainDensity = GENERATE (0.5f, 2.0f, 5.0f, 10.0f);
+    config.blockSize = GENERATE (64, 512);
+
+    runThroughput (config);
+}
+
+TEST_CASE ("Parallel branch throughput by worker threads", "[throughput][workers]")
+{
+    // heavy branches at small blocks, where a single core runs out first
+    ThroughputConfig config;
+    config.mode = GENERATE (SignalPathManager::Parallel, SignalPathManager::SendReturn);
+    config.grainSize = 2.0f;
+    config.grainDensity = 10.0f;
+    config.blockSize = GENERATE (32, 64, 256);
+    config.numWorkerThreads = GENERATE (0, 1, 2);
+
+    runThroughput (config);
+}
+
+TEST_CASE ("Granular throughput by kernel instruction set", "[throughput][isa]")
+{
+    // every instruction set this machine runs, against each interpolation
+    // quality (the gathers are where the sets differ most)
+    ThroughputConfig config;
+    config.mode = SignalPathManager::GranularOnly;
+    config.grainSize = 2.0f;
+    config.grainDensity = 10.0f;
+    config.grainQuality = GENERATE (range (0, static_cast<int> (Interpolation::numQualities)));
+    config.isa = static_cast<KernelDispatch::Isa> (GENERATE (range (0, static_cast<int> (KernelDispatch::numIsas))));
+
+    if (KernelDispatch::isSupported (config.isa))
+        runThroughput (config);
+
+    KernelDispatch::clearIsaOverride();
+}
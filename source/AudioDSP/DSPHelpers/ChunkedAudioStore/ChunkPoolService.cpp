@@ -0,0 +1,41 @@
+#include "ChunkPoolService.h"
+#include "ChunkedAudioStore.h"
+
+ChunkPoolService::ChunkPoolService()
+    : juce::Thread("Chunk pool service")
+{
+    // at normal priority, a starved service thread is what leaves a store's
+    // pool dry (see ChunkedAudioStore::getReserveChunks)
+    startThread(juce::Thread::Priority::normal);
+}
+
+ChunkPoolService::~ChunkPoolService()
+{
+    stopThread(1000);
+}
+
+void ChunkPoolService::addStore(ChunkedAudioStore* store)
+{
+    const juce::ScopedLock sl(lock);
+    stores.addIfNotAlreadyThere(store);
+}
+
+void ChunkPoolService::removeStore(ChunkedAudioStore* store)
+{
+    const juce::ScopedLock sl(lock);
+    stores.removeFirstMatchingValue(store);
+}
+
+void ChunkPoolService::run()
+{
+    while (!threadShouldExit())
+    {
+        {
+            const juce::ScopedLock sl(lock);
+            for (auto* store : stores)
+                store->service();
+        }
+
+        wait(servicePeriodMs);
+    }
+}
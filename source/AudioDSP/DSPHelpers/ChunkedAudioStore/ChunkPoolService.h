@@ -0,0 +1,49 @@
+/**
+ * @file ChunkPoolService.h
+ * @brief Background thread that keeps every ChunkedAudioStore's chunk pool topped up
+ *
+ * One instance is shared by all stores in the process (through a
+ * juce::SharedResourcePointer), so 64 plugin instances still only cost one
+ * thread. Every few milliseconds it asks each registered store to recycle the
+ * chunks its audio thread handed back and to refill its pool of free chunks,
+ * which is where all allocation, zeroing and freeing happens.
+ *
+ * @description
+ * servicePeriodMs: How often the pools are serviced
+ */
+
+#pragma once
+
+#ifndef CHUNKPOOLSERVICE_H
+#define CHUNKPOOLSERVICE_H
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+class ChunkedAudioStore;
+
+class ChunkPoolService : private juce::Thread
+{
+public:
+    static constexpr int servicePeriodMs = 10;
+
+    ChunkPoolService();
+    ~ChunkPoolService() override;
+
+    // register/unregister a store (message thread, takes the service lock)
+    void addStore(ChunkedAudioStore* store);
+    void removeStore(ChunkedAudioStore* store);
+
+    // held while the stores are serviced, so a store can restructure its
+    // pool from prepare without racing the background thread
+    [[nodiscard]] const juce::CriticalSection& getLock() const noexcept { return lock; }
+
+private:
+    void run() override;
+
+    juce::CriticalSection lock;
+    juce::Array<ChunkedAudioStore*> stores;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChunkPoolService)
+};
+
+#endif //CHUNKPOOLSERVICE_H
@@ -0,0 +1,253 @@
+#include "ChunkedAudioStore.h"
+
+ChunkedAudioStore::ChunkedAudioStore()
+{
+    // empty constructor, nothing is allocated until prepare
+}
+
+ChunkedAudioStore::~ChunkedAudioStore()
+{
+    // stop being serviced before the pool goes away
+    poolService->removeStore(this);
+    freeAllChunks();
+}
+
+int ChunkedAudioStore::getReserveChunks(double sampleRate, int maxBlockSize, int chunkSizeToUse)
+{
+    jassert(sampleRate > 0.0 && chunkSizeToUse > 0);
+
+    const auto samples = sampleRate * reserveServicePeriods * ChunkPoolService::servicePeriodMs / 1000.0 + maxBlockSize;
+    return juce::jmax(defaultReserveChunks, static_cast<int>(std::ceil(samples / chunkSizeToUse)));
+}
+
+void ChunkedAudioStore::prepare(int numChannelsToUse, int minimumCapacity, int chunkSizeToUse, int reserveChunksToUse)
+{
+    jassert(numChannelsToUse > 0 && minimumCapacity > 0);
+    jassert(juce::isPowerOfTwo(chunkSizeToUse) && reserveChunksToUse > 0);
+
+    // the service thread mustn't touch the pool while it's rebuilt
+    const juce::ScopedLock sl(poolService->getLock());
+
+    freeAllChunks();
+
+    numChannels = numChannelsToUse;
+    chunkSize = chunkSizeToUse;
+    chunkMask = chunkSize - 1;
+    chunkShift = 0;
+    while ((1 << chunkShift) < chunkSize)
+        ++chunkShift;
+
+    // at least one whole chunk, so every index maps to exactly one chunk
+    capacity = juce::nextPowerOfTwo(juce::jmax(chunkSize, minimumCapacity));
+    mask = capacity - 1;
+    const auto numChunks = capacity / chunkSize;
+
+    // every chunk reads as silence until it's written
+    zeroChunk.assign(static_cast<size_t>(numChannels * chunkSize), 0.0f);
+    chunkTable.assign(static_cast<size_t>(numChunks), zeroChunk.data());
+    numMappedChunks = 0;
+    reserveChunks = reserveChunksToUse;
+    numDroppedSamples = 0;
+
+    // the return fifo can hold every chunk that can be out at once (mapped
+    // plus the pool), so handing chunks back never fails
+    freeFifo.setTotalSize(reserveChunksToUse + 1);
+    freeSlots.assign(static_cast<size_t>(reserveChunksToUse + 1), nullptr);
+    returnFifo.setTotalSize(numChunks + reserveChunksToUse + 1);
+    returnSlots.assign(static_cast<size_t>(numChunks + reserveChunksToUse + 1), nullptr);
+
+    // fill the pool up front, after that the service thread keeps it full
+    service();
+
+    poolService->addStore(this);
+}
+
+void ChunkedAudioStore::release()
+{
+    // once we're off the service list nothing else touches the pool
+    poolService->removeStore(this);
+    freeAllChunks();
+
+    std::vector<float*>().swap(chunkTable);
+    std::vector<float>().swap(zeroChunk);
+    std::vector<float*>().swap(freeSlots);
+    std::vector<float*>().swap(returnSlots);
+
+    numChannels = 0;
+    capacity = 0;
+    mask = 0;
+}
+
+bool ChunkedAudioStore::ensureMapped(int start, int numSamples) noexcept
+{
+    bool allMapped = true;
+
+    forEachRun(start, numSamples, [this, &allMapped](size_t chunkIndex, int, int, int)
+    {
+        if (isMapped(chunkIndex))
+            return;
+
+        int start1, size1, start2, size2;
+        freeFifo.prepareToRead(1, start1, size1, start2, size2);
+        if (size1 == 0)
+        {
+            // the pool ran dry, this chunk stays silent until the next block
+            allMapped = false;
+            return;
+        }
+
+        chunkTable[chunkIndex] = freeSlots[static_cast<size_t>(start1)];
+        freeFifo.finishedRead(1);
+        ++numMappedChunks;
+    });
+
+    return allMapped;
+}
+
+void ChunkedAudioStore::copyIn(int channel, int start, const float* source, int numSamples) noexcept
+{
+    forEachRun(start, numSamples, [this, channel, source](size_t chunkIndex, int offset, int done, int run)
+    {
+        if (isMapped(chunkIndex))
+            juce::FloatVectorOperations::copy(chunkTable[chunkIndex] + channel * chunkSize + offset, source + done, run);
+        else
+            countDropped(run);
+    });
+}
+
+void ChunkedAudioStore::addIn(int channel, int start, const float* source, int numSamples) noexcept
+{
+    forEachRun(start, numSamples, [this, channel, source](size_t chunkIndex, int offset, int done, int run)
+    {
+        if (isMapped(chunkIndex))
+            juce::FloatVectorOperations::add(chunkTable[chunkIndex] + channel * chunkSize + offset, source + done, run);
+        else
+            countDropped(run);
+    });
+}
+
+void ChunkedAudioStore::copyOut(int channel, int start, float* dest, int numSamples) const noexcept
+{
+    forEachRun(start, numSamples, [this, channel, dest](size_t chunkIndex, int offset, int done, int run)
+    {
+        juce::FloatVectorOperations::copy(dest + done, chunkTable[chunkIndex] + channel * chunkSize + offset, run);
+    });
+}
+
+void ChunkedAudioStore::releaseOutside(int liveStart, int liveLength) noexcept
+{
+    const auto numChunks = chunkTable.size();
+    const auto start = wrap(liveStart);
+    const auto firstLive = static_cast<size_t>(start >> chunkShift);
+    const auto numLive = static_cast<size_t>(juce::jlimit(1, static_cast<int>(numChunks),
+                                                          ((start & chunkMask) + liveLength - 1) / chunkSize + 1));
+
+    // nothing to do in the steady state, where every mapped chunk is live
+    int mappedLive = 0;
+    for (size_t i = 0; i < numLive; ++i)
+        mappedLive += isMapped((firstLive + i) % numChunks) ? 1 : 0;
+
+    if (mappedLive == numMappedChunks)
+        return;
+
+    // everything from the end of the live run back round to its start is free
+    for (size_t i = numLive; i < numChunks; ++i)
+    {
+        const auto chunkIndex = (firstLive + i) % numChunks;
+        if (isMapped(chunkIndex))
+            releaseChunk(chunkIndex);
+    }
+}
+
+void ChunkedAudioStore::releaseAll() noexcept
+{
+    for (size_t chunkIndex = 0; chunkIndex < chunkTable.size(); ++chunkIndex)
+        if (isMapped(chunkIndex))
+            releaseChunk(chunkIndex);
+}
+
+void ChunkedAudioStore::releaseChunk(size_t chunkIndex) noexcept
+{
+    int start1, size1, start2, size2;
+    returnFifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    // sized for every chunk that can be out at once, so this can't fail
+    jassert(size1 == 1);
+    if (size1 == 0)
+        return;
+
+    returnSlots[static_cast<size_t>(start1)] = chunkTable[chunkIndex];
+    returnFifo.finishedWrite(1);
+
+    chunkTable[chunkIndex] = zeroChunk.data();
+    --numMappedChunks;
+}
+
+void ChunkedAudioStore::service()
+{
+    const auto chunkFloats = static_cast<size_t>(numChannels * chunkSize);
+    int start1, size1, start2, size2;
+
+    // recycle handed-back chunks into the pool, free the rest
+    returnFifo.prepareToRead(returnFifo.getNumReady(), start1, size1, start2, size2);
+    const auto recycle = [&](int start, int size)
+    {
+        for (int i = start; i < start + size; ++i)
+        {
+            auto* chunk = returnSlots[static_cast<size_t>(i)];
+
+            int freeStart1, freeSize1, freeStart2, freeSize2;
+            freeFifo.prepareToWrite(1, freeStart1, freeSize1, freeStart2, freeSize2);
+            if (freeSize1 == 0)
+            {
+                delete[] chunk;
+                continue;
+            }
+
+            std::fill(chunk, chunk + chunkFloats, 0.0f);
+            freeSlots[static_cast<size_t>(freeStart1)] = chunk;
+            freeFifo.finishedWrite(1);
+        }
+    };
+    recycle(start1, size1);
+    recycle(start2, size2);
+    returnFifo.finishedRead(size1 + size2);
+
+    // top the pool up with fresh chunks
+    while (freeFifo.getFreeSpace() > 0)
+    {
+        freeFifo.prepareToWrite(1, start1, size1, start2, size2);
+        freeSlots[static_cast<size_t>(start1)] = allocateChunk();
+        freeFifo.finishedWrite(1);
+    }
+}
+
+float* ChunkedAudioStore::allocateChunk() const
+{
+    // value-initialised, so the chunk arrives zeroed
+    return new float[static_cast<size_t>(numChannels * chunkSize)]();
+}
+
+void ChunkedAudioStore::freeAllChunks()
+{
+    // only called with the audio thread stopped, and with the service lock held
+    // or the store off the service list
+    for (auto& chunk : chunkTable)
+    {
+        if (chunk != zeroChunk.data())
+            delete[] chunk;
+        chunk = zeroChunk.data();
+    }
+    numMappedChunks = 0;
+
+    int start1, size1, start2, size2;
+    freeFifo.prepareToRead(freeFifo.getNumReady(), start1, size1, start2, size2);
+    for (int i = 0; i < size1; ++i) delete[] freeSlots[static_cast<size_t>(start1 + i)];
+    for (int i = 0; i < size2; ++i) delete[] freeSlots[static_cast<size_t>(start2 + i)];
+    freeFifo.finishedRead(size1 + size2);
+
+    returnFifo.prepareToRead(returnFifo.getNumReady(), start1, size1, start2, size2);
+    for (int i = 0; i < size1; ++i) delete[] returnSlots[static_cast<size_t>(start1 + i)];
+    for (int i = 0; i < size2; ++i) delete[] returnSlots[static_cast<size_t>(start2 + i)];
+    returnFifo.finishedRead(size1 + size2);
+}
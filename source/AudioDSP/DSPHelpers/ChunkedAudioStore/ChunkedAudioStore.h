@@ -0,0 +1,172 @@
+/**
+ * @file ChunkedAudioStore.h
+ * @brief Multichannel sample store that commits memory in chunks as it's written
+ *
+ * The logical buffer (a power of two samples per channel, indexed with a mask
+ * like RingBuffer) is split into fixed-size chunks. Every chunk starts out
+ * mapped to a shared all-zero chunk, so reading anywhere is always valid and
+ * costs no memory. Before a block writes a region the owner calls
+ * ensureMapped(), which takes pre-zeroed chunks from a lock-free pool, and
+ * chunks the owner no longer needs are handed back with releaseOutside() or
+ * releaseAll(). The audio thread only ever moves pointers through two
+ * single-producer/single-consumer FIFOs; the shared ChunkPoolService thread
+ * does all the allocating, zeroing and freeing.
+ *
+ * The pool is sized with getReserveChunks() to cover reserveServicePeriods of
+ * the service thread at the sample rate, so a service thread that's held up
+ * for a while (it serves every store in the process) doesn't leave the audio
+ * thread short. If the pool does run dry, the writes to the missing chunks
+ * are dropped (they read back as silence) rather than blocking or
+ * allocating, and counted in getNumDroppedSamples().
+ *
+ * @description
+ * chunkSize: Samples per channel in one chunk (power of two)
+ * reserveChunks: Free chunks kept ready in the pool for the audio thread
+ * reserveServicePeriods: How many service periods of writing the reserve covers
+ * chunkTable: One pointer per chunk, either a pooled chunk or the zero chunk
+ */
+
+#pragma once
+
+#ifndef CHUNKEDAUDIOSTORE_H
+#define CHUNKEDAUDIOSTORE_H
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "ChunkPoolService.h"
+#include <atomic>
+#include <vector>
+
+class ChunkedAudioStore
+{
+public:
+    static constexpr int defaultChunkSize = 8192;
+    static constexpr int defaultReserveChunks = 4;
+    static constexpr int reserveServicePeriods = 20;
+
+    ChunkedAudioStore();
+    ~ChunkedAudioStore();
+
+    // chunks to keep in reserve for a store written at sampleRate in blocks
+    // of up to maxBlockSize: reserveServicePeriods of samples plus a block,
+    // rounded up, and never fewer than defaultReserveChunks
+    [[nodiscard]] static int getReserveChunks(double sampleRate, int maxBlockSize, int chunkSizeToUse = defaultChunkSize);
+
+    // size the chunk table for at least minimumCapacity samples per channel
+    // (rounded up to a power of two), drop all contents and fill the pool.
+    // Allocates, so call from prepare
+    void prepare(int numChannels, int minimumCapacity,
+                 int chunkSizeToUse = defaultChunkSize,
+                 int reserveChunksToUse = defaultReserveChunks);
+
+    // free every chunk and the chunk table and stop being serviced, prepare()
+    // brings the store back. Frees, so not from the audio thread
+    void release();
+
+    [[nodiscard]] int getCapacity() const noexcept { return capacity; }
+    [[nodiscard]] int getNumChannels() const noexcept { return numChannels; }
+    [[nodiscard]] int getChunkSize() const noexcept { return chunkSize; }
+    [[nodiscard]] int getNumMappedChunks() const noexcept { return numMappedChunks; }
+    [[nodiscard]] int getNumReserveChunks() const noexcept { return reserveChunks; }
+
+    // samples (per channel) written to chunks the pool had none for since
+    // prepare, which were lost (any thread)
+    [[nodiscard]] juce::int64 getNumDroppedSamples() const noexcept { return numDroppedSamples.load(std::memory_order_relaxed); }
+
+    // wrap any (possibly negative) index into the store
+    [[nodiscard]] int wrap(int index) const noexcept { return index & mask; }
+
+    //=audio thread=============================================================
+
+    // map every chunk overlapping [start, start + numSamples) (wrapping),
+    // returns false if the pool ran out before all of them were mapped
+    bool ensureMapped(int start, int numSamples) noexcept;
+
+    [[nodiscard]] float read(int channel, int index) const noexcept
+    {
+        const auto i = index & mask;
+        return chunkTable[static_cast<size_t>(i >> chunkShift)][channel * chunkSize + (i & chunkMask)];
+    }
+
+    // writes to an unmapped chunk are dropped, so the zero chunk stays zero
+    void write(int channel, int index, float value) noexcept
+    {
+        const auto i = index & mask;
+        auto* chunk = chunkTable[static_cast<size_t>(i >> chunkShift)];
+        if (chunk != zeroChunk.data())
+            chunk[channel * chunkSize + (i & chunkMask)] = value;
+        else
+            countDropped(1);
+    }
+
+    // block copies in and out, split at chunk boundaries and the wrap point
+    void copyIn(int channel, int start, const float* source, int numSamples) noexcept;
+    void addIn(int channel, int start, const float* source, int numSamples) noexcept;
+    void copyOut(int channel, int start, float* dest, int numSamples) const noexcept;
+
+    // hand back every mapped chunk that doesn't overlap [liveStart, liveStart + liveLength)
+    void releaseOutside(int liveStart, int liveLength) noexcept;
+
+    // hand back every mapped chunk, which makes the whole store read as silence
+    void releaseAll() noexcept;
+
+    //=background thread========================================================
+
+    // recycle handed-back chunks into the pool (freeing any it has no room
+    // for) and top the pool up, called by ChunkPoolService
+    void service();
+
+private:
+    // walk [start, start + numSamples) one chunk-contiguous run at a time
+    template <typename Function>
+    void forEachRun(int start, int numSamples, Function&& function) const noexcept
+    {
+        numSamples = juce::jmin(numSamples, capacity);
+        for (int done = 0; done < numSamples;)
+        {
+            const auto i = (start + done) & mask;
+            const auto offset = i & chunkMask;
+            const auto run = juce::jmin(numSamples - done, chunkSize - offset);
+            function(static_cast<size_t>(i >> chunkShift), offset, done, run);
+            done += run;
+        }
+    }
+
+    [[nodiscard]] bool isMapped(size_t chunkIndex) const noexcept { return chunkTable[chunkIndex] != zeroChunk.data(); }
+    void releaseChunk(size_t chunkIndex) noexcept;
+
+    // only the audio thread writes the count, so no read-modify-write needed
+    void countDropped(int numSamples) noexcept
+    {
+        numDroppedSamples.store(numDroppedSamples.load(std::memory_order_relaxed) + numSamples, std::memory_order_relaxed);
+    }
+
+    float* allocateChunk() const;
+    void freeAllChunks();
+
+    int numChannels = 0;
+    int capacity = 0;
+    int mask = 0;
+    int chunkSize = defaultChunkSize;
+    int chunkShift = 0;
+    int chunkMask = defaultChunkSize - 1;
+    int numMappedChunks = 0;
+    int reserveChunks = 0;
+    std::atomic<juce::int64> numDroppedSamples { 0 };
+
+    std::vector<float*> chunkTable;
+    std::vector<float> zeroChunk;
+
+    // free chunks: filled by the service thread, taken by the audio thread
+    juce::AbstractFifo freeFifo { 2 };
+    std::vector<float*> freeSlots;
+
+    // handed-back chunks: filled by the audio thread, drained by the service thread
+    juce::AbstractFifo returnFifo { 2 };
+    std::vector<float*> returnSlots;
+
+    juce::SharedResourcePointer<ChunkPoolService> poolService;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChunkedAudioStore)
+};
+
+#endif //CHUNKEDAUDIOSTORE_H
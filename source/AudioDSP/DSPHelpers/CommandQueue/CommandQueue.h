@@ -0,0 +1,113 @@
+/**
+ * @file CommandQueue.h
+ * @brief Bounded lock-free queue that carries commands from any thread to the audio thread
+ *
+ * Any number of threads may push (the message thread, a host automation
+ * thread, the audio thread itself), and one thread pops, normally the audio
+ * thread at the start of a block. Every cell carries a sequence number that
+ * says whether it's free for the producer at a position or holds a command for
+ * the consumer at that position, so pushing only takes one compare-and-swap on
+ * the shared enqueue position and nothing ever blocks or allocates.
+ *
+ * Commands are copied in and out, so they should be small and trivially
+ * copyable. A full queue rejects the push instead of waiting.
+ *
+ * @description
+ * capacity: Commands the queue can hold (power of two)
+ */
+
+#pragma once
+
+#ifndef COMMANDQUEUE_H
+#define COMMANDQUEUE_H
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <array>
+#include <atomic>
+#include <type_traits>
+
+template <typename Command, size_t capacity>
+class CommandQueue
+{
+public:
+    static_assert((capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+    static_assert(std::is_trivially_copyable_v<Command>, "commands are copied between threads");
+
+    CommandQueue()
+    {
+        for (size_t i = 0; i < capacity; ++i)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // queue a command (any thread, lock-free), false if the queue is full
+    bool push(const Command& command) noexcept
+    {
+        auto position = enqueuePosition.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            auto& cell = cells[position & mask];
+            const auto sequence = cell.sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+            if (difference == 0)
+            {
+                // the cell is free for this position, claim it
+                if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    cell.command = command;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0)
+            {
+                // the consumer hasn't freed this cell yet, we're full
+                return false;
+            }
+            else
+            {
+                // another producer took this position
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // take the oldest command (consumer thread only), false if there's none
+    bool pop(Command& command) noexcept
+    {
+        auto& cell = cells[dequeuePosition & mask];
+        const auto sequence = cell.sequence.load(std::memory_order_acquire);
+
+        // not written yet, or the producer is still copying it in
+        if (sequence != dequeuePosition + 1)
+            return false;
+
+        command = cell.command;
+
+        // free the cell for the producer one lap ahead
+        cell.sequence.store(dequeuePosition + capacity, std::memory_order_release);
+        ++dequeuePosition;
+        return true;
+    }
+
+private:
+    static constexpr size_t mask = capacity - 1;
+
+    struct Cell
+    {
+        std::atomic<size_t> sequence { 0 };
+        Command command {};
+    };
+
+    std::array<Cell, capacity> cells;
+
+    // producers and the consumer write different ends, keep them on
+    // separate cache lines
+    alignas(64) std::atomic<size_t> enqueuePosition { 0 };
+    alignas(64) size_t dequeuePosition = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CommandQueue)
+};
+
+#endif //COMMANDQUEUE_H
@@ -0,0 +1,185 @@
+#include "Interpolation.h"
+#include "../KernelDispatch/KernelDispatch.h"
+
+void Interpolation::SincTable::prepare()
+{
+    constexpr auto pi = juce::MathConstants<double>::pi;
+    constexpr double halfWidth = numTaps / 2;
+    constexpr double cutoff = 0.92; // relative to nyquist, keeps the transition band below it
+
+    coefficients.resize(static_cast<size_t>((numPhases + 1) * numTaps));
+
+    for (int phase = 0; phase <= numPhases; ++phase)
+    {
+        const auto frac = static_cast<double>(phase) / numPhases;
+        auto* row = coefficients.data() + phase * numTaps;
+        double sum = 0.0;
+
+        // tap j sits at offset (j - numTaps / 2 + 1) from the integer index
+        for (int tap = 0; tap < numTaps; ++tap)
+        {
+            const auto t = static_cast<double>(tap - numTaps / 2 + 1) - frac;
+            const auto x = pi * cutoff * t;
+            const auto sinc = std::abs(x) < 1.0e-9 ? 1.0 : std::sin(x) / x;
+            const auto window = std::abs(t) >= halfWidth
+                ? 0.0
+                : 0.42 + 0.5 * std::cos(pi * t / halfWidth) + 0.08 * std::cos(2.0 * pi * t / halfWidth);
+
+            const auto value = sinc * window;
+            row[tap] = static_cast<float>(value);
+            sum += value;
+        }
+
+        // normalise each phase to unity gain at DC
+        for (int tap = 0; tap < numTaps; ++tap)
+            row[tap] = static_cast<float>(row[tap] / sum);
+    }
+}
+
+void Interpolation::computePositions(float startPosition, float increment,
+                                     int* indices, float* fractions, int numSamples) noexcept
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto position = startPosition + static_cast<float>(i) * increment;
+        const auto floored = std::floor(position);
+        indices[i] = static_cast<int>(floored);
+        fractions[i] = position - floored;
+    }
+}
+
+void Interpolation::gather(Quality quality, const float* data, int mask,
+                           const int* indices, const float* fractions,
+                           float* dest, int numSamples, const SincTable& sincTable) noexcept
+{
+    gatherLoops(quality, data, mask, indices, fractions, dest, numSamples, sincTable);
+}
+
+#if KERNEL_DISPATCH_X86
+KERNEL_DISPATCH_TARGET_AVX2 void Interpolation::gatherAvx2(Quality quality, const float* data, int mask,
+                                                           const int* indices, const float* fractions,
+                                                           float* dest, int numSamples, const SincTable& sincTable) noexcept
+{
+    gatherLoops(quality, data, mask, indices, fractions, dest, numSamples, sincTable);
+}
+#endif
+
+void Interpolation::gatherLoops(Quality quality, const float* __restrict data, int mask,
+                                const int* indices, const float* fractions,
+                                float* __restrict dest, int numSamples, const SincTable& sincTable) noexcept
+{
+    switch (quality)
+    {
+        case Hermite:
+            gatherHermite(data, mask, indices, fractions, dest, numSamples);
+            break;
+
+        case Lagrange:
+            gatherLagrange(data, mask, indices, fractions, dest, numSamples);
+            break;
+
+        case Sinc:
+            jassert(sincTable.isPrepared());
+            gatherSinc(data, mask, indices, fractions, dest, numSamples, sincTable);
+            break;
+
+        case Linear:
+        case numQualities:
+        default:
+            gatherLinear(data, mask, indices, fractions, dest, numSamples);
+            break;
+    }
+}
+
+void Interpolation::gatherLinear(const float* __restrict data, int mask, const int* indices,
+                                 const float* fractions, float* __restrict dest, int numSamples) noexcept
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto index = indices[i];
+        const auto x0 = data[index & mask];
+        const auto x1 = data[(index + 1) & mask];
+
+        dest[i] = x0 + fractions[i] * (x1 - x0);
+    }
+}
+
+void Interpolation::gatherHermite(const float* __restrict data, int mask, const int* indices,
+                                  const float* fractions, float* __restrict dest, int numSamples) noexcept
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto index = indices[i];
+        const auto d = fractions[i];
+        const auto xm1 = data[(index - 1) & mask];
+        const auto x0 = data[index & mask];
+        const auto x1 = data[(index + 1) & mask];
+        const auto x2 = data[(index + 2) & mask];
+
+        const auto c1 = 0.5f * (x1 - xm1);
+        const auto c2 = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+        const auto c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+
+        dest[i] = ((c3 * d + c2) * d + c1) * d + x0;
+    }
+}
+
+void Interpolation::gatherLagrange(const float* __restrict data, int mask, const int* indices,
+                                   const float* fractions, float* __restrict dest, int numSamples) noexcept
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto index = indices[i];
+        const auto d = fractions[i];
+
+        // (d - k) for each of the six points at offsets -2 to 3
+        const auto dm2 = d + 2.0f;
+        const auto dm1 = d + 1.0f;
+        const auto d1 = d - 1.0f;
+        const auto d2 = d - 2.0f;
+        const auto d3 = d - 3.0f;
+
+        const auto c0 = -dm1 * d * d1 * d2 * d3 * (1.0f / 120.0f);
+        const auto c1 = dm2 * d * d1 * d2 * d3 * (1.0f / 24.0f);
+        const auto c2 = -dm2 * dm1 * d1 * d2 * d3 * (1.0f / 12.0f);
+        const auto c3 = dm2 * dm1 * d * d2 * d3 * (1.0f / 12.0f);
+        const auto c4 = -dm2 * dm1 * d * d1 * d3 * (1.0f / 24.0f);
+        const auto c5 = dm2 * dm1 * d * d1 * d2 * (1.0f / 120.0f);
+
+        dest[i] = c0 * data[(index - 2) & mask]
+                + c1 * data[(index - 1) & mask]
+                + c2 * data[index & mask]
+                + c3 * data[(index + 1) & mask]
+                + c4 * data[(index + 2) & mask]
+                + c5 * data[(index + 3) & mask];
+    }
+}
+
+void Interpolation::gatherSinc(const float* __restrict data, int mask, const int* indices,
+                               const float* fractions, float* __restrict dest, int numSamples,
+                               const SincTable& sincTable) noexcept
+{
+    constexpr int numTaps = SincTable::numTaps;
+    constexpr int firstTap = 1 - numTaps / 2;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        // blend the two nearest phase rows
+        const auto row = fractions[i] * static_cast<float>(SincTable::numPhases);
+        const auto phase = juce::jmin(static_cast<int>(row), SincTable::numPhases - 1);
+        const auto blend = row - static_cast<float>(phase);
+        const auto* lower = sincTable.getPhase(phase);
+        const auto* upper = sincTable.getPhase(phase + 1);
+
+        const auto index = indices[i] + firstTap;
+        float sum = 0.0f;
+
+        for (int tap = 0; tap < numTaps; ++tap)
+        {
+            const auto coefficient = lower[tap] + blend * (upper[tap] - lower[tap]);
+            sum += coefficient * data[(index + tap) & mask];
+        }
+
+        dest[i] = sum;
+    }
+}
@@ -0,0 +1,101 @@
+/**
+ * @file Interpolation.h
+ * @brief Block interpolation kernels for reading fractional positions from a ring buffer
+ *
+ * Reading is split in two passes so the index math can be shared between
+ * channels: computePositions() turns a start position + increment into integer
+ * indices and fractions once per block, then gather() reads each channel
+ * using those arrays. The gather loops are branch-free and mask every index,
+ * so they work directly on RingBuffer storage and vectorise cleanly.
+ *
+ * gather() is built for the baseline instruction set and gatherAvx2() is the
+ * same loops built for AVX2 (see KernelDispatch, which only hands it out on
+ * CPUs that run it). There's no AVX-512 build, 16-wide gathers measured slower
+ * than 8-wide ones.
+ *
+ * @description
+ * Linear: 2-point linear interpolation, cheapest, dulls the top end
+ * Hermite: 4-point, 3rd-order Hermite (Catmull-Rom)
+ * Lagrange: 6-point, 5th-order Lagrange
+ * Sinc: 8-tap Blackman-windowed sinc from a polyphase table, highest fidelity
+ */
+
+#pragma once
+
+#ifndef INTERPOLATION_H
+#define INTERPOLATION_H
+
+#include <juce_core/juce_core.h>
+#include <vector>
+
+class Interpolation
+{
+public:
+    // interpolation quality, must match the choices in the grainQuality parameter
+    enum Quality
+    {
+        Linear = 0,
+        Hermite = 1,
+        Lagrange = 2,
+        Sinc = 3,
+        numQualities
+    };
+
+    // polyphase windowed-sinc coefficient table, shared by every channel
+    class SincTable
+    {
+    public:
+        static constexpr int numTaps = 8;       // taps per phase, centred on the read position
+        static constexpr int numPhases = 256;   // fractional positions between two samples
+
+        // compute the table (allocates, so only call this from prepare)
+        void prepare();
+
+        [[nodiscard]] bool isPrepared() const noexcept { return ! coefficients.empty(); }
+
+        // coefficients for phase row (0 - numPhases inclusive)
+        [[nodiscard]] const float* getPhase(int phase) const noexcept { return coefficients.data() + phase * numTaps; }
+
+    private:
+        std::vector<float> coefficients;
+    };
+
+    // convert numSamples positions (startPosition + i * increment) into
+    // integer indices (not yet wrapped) and fractions in [0, 1)
+    static void computePositions(float startPosition, float increment,
+                                 int* indices, float* fractions, int numSamples) noexcept;
+
+    // read numSamples interpolated values from a power-of-two buffer using
+    // indices + fractions from computePositions, dispatching on quality
+    static void gather(Quality quality, const float* data, int mask,
+                       const int* indices, const float* fractions,
+                       float* dest, int numSamples, const SincTable& sincTable) noexcept;
+
+    using GatherFunction = decltype(&gather);
+
+    // gather built for AVX2 + FMA (x86 builds with GCC or Clang only, and
+    // only callable on CPUs that support it)
+    static void gatherAvx2(Quality quality, const float* data, int mask,
+                           const int* indices, const float* fractions,
+                           float* dest, int numSamples, const SincTable& sincTable) noexcept;
+
+private:
+    // the gather loops, inlined into both gather entry points above so each
+    // copy is vectorised for its own instruction set (dest never overlaps the
+    // buffer being read, and the compiler can't check that at run time for
+    // masked indices, hence __restrict)
+    static forcedinline void gatherLoops(Quality quality, const float* __restrict data, int mask,
+                                         const int* indices, const float* fractions,
+                                         float* __restrict dest, int numSamples, const SincTable& sincTable) noexcept;
+    static forcedinline void gatherLinear(const float* __restrict data, int mask, const int* indices,
+                                          const float* fractions, float* __restrict dest, int numSamples) noexcept;
+    static forcedinline void gatherHermite(const float* __restrict data, int mask, const int* indices,
+                                           const float* fractions, float* __restrict dest, int numSamples) noexcept;
+    static forcedinline void gatherLagrange(const float* __restrict data, int mask, const int* indices,
+                                            const float* fractions, float* __restrict dest, int numSamples) noexcept;
+    static forcedinline void gatherSinc(const float* __restrict data, int mask, const int* indices,
+                                        const float* fractions, float* __restrict dest, int numSamples,
+                                        const SincTable& sincTable) noexcept;
+};
+
+#endif //INTERPOLATION_H
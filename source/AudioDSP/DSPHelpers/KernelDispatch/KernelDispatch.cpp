@@ -0,0 +1,174 @@
+#include "KernelDispatch.h"
+#include <bit>
+
+std::atomic<int> KernelDispatch::isaOverride { -1 };
+
+bool KernelDispatch::isSupported(Isa isa) noexcept
+{
+    switch (isa)
+    {
+        case Generic:
+            return true;
+
+       #if KERNEL_DISPATCH_X86
+        case Avx2:
+            return juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3();
+
+        case Avx512:
+            return isSupported(Avx2) && juce::SystemStats::hasAVX512F() && juce::SystemStats::hasAVX512VL();
+       #endif
+
+        case numIsas:
+        default:
+            return false;
+    }
+}
+
+KernelDispatch::Isa KernelDispatch::getBestSupportedIsa() noexcept
+{
+    // CPUID only needs asking once
+    static const auto best = []
+    {
+        auto isa = static_cast<int>(numIsas) - 1;
+        while (isa > Generic && !isSupported(static_cast<Isa>(isa)))
+            --isa;
+
+        return static_cast<Isa>(isa);
+    }();
+
+    return best;
+}
+
+void KernelDispatch::setIsaOverride(Isa isa) noexcept
+{
+    jassert(isa >= Generic && isa < numIsas);
+    isaOverride.store(juce::jlimit(static_cast<int>(Generic), static_cast<int>(getBestSupportedIsa()), static_cast<int>(isa)));
+}
+
+void KernelDispatch::clearIsaOverride() noexcept
+{
+    isaOverride.store(-1);
+}
+
+KernelDispatch::Isa KernelDispatch::selectIsa() noexcept
+{
+    const auto forced = isaOverride.load();
+    return forced >= 0 ? static_cast<Isa>(forced) : getBestSupportedIsa();
+}
+
+const KernelDispatch::Kernels& KernelDispatch::getKernels(Isa isa) noexcept
+{
+    jassert(isSupported(isa));
+
+    static const Kernels generic { Generic, Interpolation::gather, addWithMultiplyGeneric, mixGeneric, scanGeneric };
+
+   #if KERNEL_DISPATCH_X86
+    static const Kernels avx2 { Avx2, Interpolation::gatherAvx2, addWithMultiplyAvx2, mixAvx2, scanAvx2 };
+    // 16-wide gathers are slower than 8-wide ones, so only the streaming
+    // loops go up to AVX-512
+    static const Kernels avx512 { Avx512, Interpolation::gatherAvx2, addWithMultiplyAvx512, mixAvx512, scanAvx512 };
+
+    if (isa == Avx512)
+        return avx512;
+    if (isa == Avx2)
+        return avx2;
+   #endif
+
+    return generic;
+}
+
+const char* KernelDispatch::getIsaName(Isa isa) noexcept
+{
+    switch (isa)
+    {
+        case Avx2: return "AVX2";
+        case Avx512: return "AVX-512";
+        case Generic:
+        case numIsas:
+        default: return "generic";
+    }
+}
+
+float KernelDispatch::BlockScan::getPeak() const noexcept
+{
+    return std::bit_cast<float>(peakBits);
+}
+
+//=Loops========================================================================
+
+void KernelDispatch::addWithMultiplyLoop(float* __restrict dest, const float* source, const float* gains, int numSamples) noexcept
+{
+    for (int i = 0; i < numSamples; ++i)
+        dest[i] += source[i] * gains[i];
+}
+
+void KernelDispatch::mixLoop(float* __restrict dest, const float* wet, const float* mixes, int numSamples) noexcept
+{
+    for (int i = 0; i < numSamples; ++i)
+        dest[i] += (wet[i] - dest[i]) * mixes[i];
+}
+
+KernelDispatch::BlockScan KernelDispatch::scanLoop(const float* samples, int numSamples) noexcept
+{
+    // integer max and or reductions only, so every set vectorises them
+    juce::uint32 peakBits = 0;
+    juce::uint32 denormals = 0;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto bits = std::bit_cast<juce::uint32>(samples[i]) & 0x7fffffffu;
+        peakBits = juce::jmax(peakBits, bits);
+
+        // a denormal is 1 to 0x007fffff, zero wraps round to the top
+        denormals |= (bits - 1u < 0x007fffffu) ? 1u : 0u;
+    }
+
+    return { peakBits, denormals != 0 };
+}
+
+void KernelDispatch::addWithMultiplyGeneric(float* dest, const float* source, const float* gains, int numSamples) noexcept
+{
+    addWithMultiplyLoop(dest, source, gains, numSamples);
+}
+
+void KernelDispatch::mixGeneric(float* dest, const float* wet, const float* mixes, int numSamples) noexcept
+{
+    mixLoop(dest, wet, mixes, numSamples);
+}
+
+KernelDispatch::BlockScan KernelDispatch::scanGeneric(const float* samples, int numSamples) noexcept
+{
+    return scanLoop(samples, numSamples);
+}
+
+#if KERNEL_DISPATCH_X86
+KERNEL_DISPATCH_TARGET_AVX2 void KernelDispatch::addWithMultiplyAvx2(float* dest, const float* source, const float* gains, int numSamples) noexcept
+{
+    addWithMultiplyLoop(dest, source, gains, numSamples);
+}
+
+KERNEL_DISPATCH_TARGET_AVX512 void KernelDispatch::addWithMultiplyAvx512(float* dest, const float* source, const float* gains, int numSamples) noexcept
+{
+    addWithMultiplyLoop(dest, source, gains, numSamples);
+}
+
+KERNEL_DISPATCH_TARGET_AVX2 void KernelDispatch::mixAvx2(float* dest, const float* wet, const float* mixes, int numSamples) noexcept
+{
+    mixLoop(dest, wet, mixes, numSamples);
+}
+
+KERNEL_DISPATCH_TARGET_AVX512 void KernelDispatch::mixAvx512(float* dest, const float* wet, const float* mixes, int numSamples) noexcept
+{
+    mixLoop(dest, wet, mixes, numSamples);
+}
+
+KERNEL_DISPATCH_TARGET_AVX2 KernelDispatch::BlockScan KernelDispatch::scanAvx2(const float* samples, int numSamples) noexcept
+{
+    return scanLoop(samples, numSamples);
+}
+
+KERNEL_DISPATCH_TARGET_AVX512 KernelDispatch::BlockScan KernelDispatch::scanAvx512(const float* samples, int numSamples) noexcept
+{
+    return scanLoop(samples, numSamples);
+}
+#endif
@@ -0,0 +1,138 @@
+/**
+ * @file KernelDispatch.h
+ * @brief Picks the hot DSP loops compiled for the best instruction set the CPU supports
+ *
+ * One binary runs on machines of different generations, so the loops that
+ * dominate the granular delay (interpolated reads, grain accumulation, the
+ * wet/dry mix, the block scans behind the signal guards) are compiled several times, each copy with a wider instruction
+ * set enabled for just that function, and the compiler vectorises each copy
+ * for its set. getKernels() returns one table of function pointers per set,
+ * and processors take the table for selectIsa() in prepare, so the audio
+ * thread only ever calls through a pointer it already holds.
+ *
+ * The CPU is queried once (CPUID, through juce::SystemStats). A process-wide
+ * override forces a lower set, for tests and for comparing sets on one
+ * machine; it's clamped to what the CPU supports and applies from the next
+ * prepare.
+ *
+ * Per-function instruction sets need GCC or Clang on x86. Other builds (MSVC,
+ * ARM) only have the generic kernels, which are compiled for the target's
+ * baseline (SSE2 on x86-64, NEON on ARM64).
+ *
+ * @description
+ * Generic: Baseline build flags
+ * Avx2: AVX2 + FMA, 8 floats per vector
+ * Avx512: AVX-512 F/VL, 16 floats per vector (the interpolated reads stay on AVX2)
+ */
+
+#pragma once
+
+#ifndef KERNELDISPATCH_H
+#define KERNELDISPATCH_H
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+
+#include "../Interpolation/Interpolation.h"
+
+#if JUCE_INTEL && (JUCE_GCC || JUCE_CLANG)
+    #define KERNEL_DISPATCH_X86 1
+    #define KERNEL_DISPATCH_TARGET_AVX2 __attribute__((target("avx2,fma")))
+    #define KERNEL_DISPATCH_TARGET_AVX512 __attribute__((target("avx512f,avx512vl,avx2,fma")))
+#else
+    #define KERNEL_DISPATCH_X86 0
+#endif
+
+class KernelDispatch
+{
+public:
+    // instruction sets, in increasing order of width
+    enum Isa
+    {
+        Generic = 0,
+        Avx2 = 1,
+        Avx512 = 2,
+        numIsas
+    };
+
+    // what a scan found in a block, read from the bits of each sample so it
+    // holds up under fast math (which assumes there are no NaNs or infinities
+    // and can fold isnan away). With the sign bit off, bigger floats have
+    // bigger bit patterns, and NaN and infinity are above every finite one
+    struct BlockScan
+    {
+        juce::uint32 peakBits = 0;  // largest |sample| as float bits
+        bool hasDenormals = false;
+
+        [[nodiscard]] bool isFinite() const noexcept { return peakBits < 0x7f800000u; }
+
+        // the peak level, only meaningful if isFinite()
+        [[nodiscard]] float getPeak() const noexcept;
+
+        // combine with the scan of another channel
+        void merge(const BlockScan& other) noexcept
+        {
+            peakBits = juce::jmax(peakBits, other.peakBits);
+            hasDenormals = hasDenormals || other.hasDenormals;
+        }
+    };
+
+    // the hot loops compiled for one instruction set
+    struct Kernels
+    {
+        Isa isa;
+
+        // interpolated reads, see Interpolation::gather
+        Interpolation::GatherFunction gather;
+
+        // dest[i] += source[i] * gains[i] (accumulating windowed grains)
+        void (*addWithMultiply)(float* dest, const float* source, const float* gains, int numSamples) noexcept;
+
+        // dest[i] += (wet[i] - dest[i]) * mixes[i] (wet/dry mix in place)
+        void (*mix)(float* dest, const float* wet, const float* mixes, int numSamples) noexcept;
+
+        // the loudest sample and whether there are denormals, see BlockScan
+        BlockScan (*scan)(const float* samples, int numSamples) noexcept;
+    };
+
+    // whether this build has the set and this CPU runs it
+    [[nodiscard]] static bool isSupported(Isa isa) noexcept;
+
+    // the widest set this build has and this CPU runs
+    [[nodiscard]] static Isa getBestSupportedIsa() noexcept;
+
+    // force a set from the next prepare on (clamped to getBestSupportedIsa),
+    // clearIsaOverride goes back to the best one
+    static void setIsaOverride(Isa isa) noexcept;
+    static void clearIsaOverride() noexcept;
+
+    // the set processors should use: the override if there is one, otherwise
+    // the best supported
+    [[nodiscard]] static Isa selectIsa() noexcept;
+
+    // the kernel table for a supported set
+    [[nodiscard]] static const Kernels& getKernels(Isa isa) noexcept;
+
+    [[nodiscard]] static const char* getIsaName(Isa isa) noexcept;
+
+private:
+    // -1 when there's no override
+    static std::atomic<int> isaOverride;
+
+    // loop bodies, inlined into one copy per set below
+    static forcedinline void addWithMultiplyLoop(float* __restrict dest, const float* source, const float* gains, int numSamples) noexcept;
+    static forcedinline void mixLoop(float* __restrict dest, const float* wet, const float* mixes, int numSamples) noexcept;
+    static forcedinline BlockScan scanLoop(const float* samples, int numSamples) noexcept;
+
+    static void addWithMultiplyGeneric(float* dest, const float* source, const float* gains, int numSamples) noexcept;
+    static void addWithMultiplyAvx2(float* dest, const float* source, const float* gains, int numSamples) noexcept;
+    static void addWithMultiplyAvx512(float* dest, const float* source, const float* gains, int numSamples) noexcept;
+    static void mixGeneric(float* dest, const float* wet, const float* mixes, int numSamples) noexcept;
+    static void mixAvx2(float* dest, const float* wet, const float* mixes, int numSamples) noexcept;
+    static void mixAvx512(float* dest, const float* wet, const float* mixes, int numSamples) noexcept;
+    static BlockScan scanGeneric(const float* samples, int numSamples) noexcept;
+    static BlockScan scanAvx2(const float* samples, int numSamples) noexcept;
+    static BlockScan scanAvx512(const float* samples, int numSamples) noexcept;
+};
+
+#endif //KERNELDISPATCH_H
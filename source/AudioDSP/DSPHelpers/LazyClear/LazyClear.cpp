@@ -0,0 +1,35 @@
+#include "LazyClear.h"
+#include <algorithm>
+
+void LazyClear::prepare(int numSamples, int pageSizeToUse)
+{
+    jassert(numSamples > 0 && juce::isPowerOfTwo(pageSizeToUse));
+
+    pageSize = pageSizeToUse;
+    pageShift = 0;
+    while ((1 << pageShift) < pageSize)
+        ++pageShift;
+
+    totalSamples = numSamples;
+
+    // stamps start one epoch behind, so nothing counts as written yet
+    epoch = 1;
+    pageEpochs.assign(static_cast<size_t>((numSamples + pageSize - 1) / pageSize), 0);
+}
+
+void LazyClear::release()
+{
+    std::vector<uint32_t>().swap(pageEpochs);
+    totalSamples = 0;
+}
+
+void LazyClear::markEmpty() noexcept
+{
+    // once every 2^32 clears the counter would meet old stamps again, so
+    // restamp everything as stale (the only O(pages) path)
+    if (++epoch == 0)
+    {
+        std::fill(pageEpochs.begin(), pageEpochs.end(), 0u);
+        epoch = 1;
+    }
+}
@@ -0,0 +1,84 @@
+/**
+ * @file LazyClear.h
+ * @brief O(1) clearing for large sample buffers via per-page epochs
+ *
+ * Splits a buffer into fixed-size pages and stamps each page with the epoch it
+ * was last zeroed in. markEmpty() just starts a new epoch, which makes every
+ * page logically empty at once. Before a block reads or writes a region, the
+ * owner calls touch(), which zeroes only the stale pages in that region and
+ * stamps them, so the physical clearing is spread over the blocks that
+ * actually use the memory, and pages that are never touched are never zeroed
+ * (or even faulted in).
+ *
+ * @description
+ * pageSize: Samples per page (power of two)
+ * epoch: Current generation, pages stamped with an older one read as silence
+ */
+
+#pragma once
+
+#ifndef LAZYCLEAR_H
+#define LAZYCLEAR_H
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <cstdint>
+#include <vector>
+
+class LazyClear
+{
+public:
+    static constexpr int defaultPageSize = 512;
+
+    LazyClear() = default;
+
+    // size the page table for a buffer of numSamples (allocates, so call from
+    // prepare), every page starts out stale
+    void prepare(int numSamples, int pageSizeToUse = defaultPageSize);
+
+    // free the page table, prepare() brings it back
+    void release();
+
+    // make the whole buffer logically empty in O(1)
+    void markEmpty() noexcept;
+
+    // zero every stale page overlapping [start, start + numSamples) by calling
+    // zeroRange(pageStart, pageLength), and mark them as current. The range is
+    // linear, ring buffers split it at the wrap point themselves
+    template <typename ZeroFunction>
+    void touch(int start, int numSamples, ZeroFunction&& zeroRange) noexcept
+    {
+        jassert(start >= 0 && start + numSamples <= totalSamples);
+        if (numSamples <= 0)
+            return;
+
+        const int firstPage = start >> pageShift;
+        const int lastPage = (start + numSamples - 1) >> pageShift;
+
+        for (int page = firstPage; page <= lastPage; ++page)
+        {
+            auto& stamp = pageEpochs[static_cast<size_t>(page)];
+            if (stamp != epoch)
+            {
+                const int pageStart = page << pageShift;
+                zeroRange(pageStart, juce::jmin(pageSize, totalSamples - pageStart));
+                stamp = epoch;
+            }
+        }
+    }
+
+    [[nodiscard]] bool isPageCurrent(int page) const noexcept { return pageEpochs[static_cast<size_t>(page)] == epoch; }
+    [[nodiscard]] int getPageSize() const noexcept { return pageSize; }
+    [[nodiscard]] int getNumPages() const noexcept { return static_cast<int>(pageEpochs.size()); }
+
+private:
+    std::vector<uint32_t> pageEpochs;
+    uint32_t epoch = 1;
+
+    int pageSize = defaultPageSize;
+    int pageShift = 9;
+    int totalSamples = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LazyClear)
+};
+
+#endif //LAZYCLEAR_H
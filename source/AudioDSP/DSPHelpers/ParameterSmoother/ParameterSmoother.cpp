@@ -0,0 +1,99 @@
+#include "ParameterSmoother.h"
+
+void ParameterSmoother::prepare(double sampleRate, int maximumBlockSize, double rampLengthSeconds, RampType type)
+{
+    jassert(sampleRate > 0.0 && maximumBlockSize > 0);
+
+    rampType = type;
+    rampLengthInSamples = juce::jmax(0, static_cast<int>(std::floor(rampLengthSeconds * sampleRate)));
+
+    values.assign(static_cast<size_t>(maximumBlockSize), currentValue);
+
+    // an exponential ramp covers ~-60 dB (a factor of 1000) over the ramp length
+    decay.assign(static_cast<size_t>(maximumBlockSize), 0.0f);
+    if (rampLengthInSamples > 0)
+    {
+        const auto coefficient = std::exp(std::log(0.001) / rampLengthInSamples);
+        auto power = 1.0;
+        for (auto& d : decay)
+        {
+            power *= coefficient;
+            d = static_cast<float>(power);
+        }
+    }
+
+    setCurrentAndTargetValue(targetValue);
+}
+
+void ParameterSmoother::setTargetValue(float newTarget) noexcept
+{
+    if (newTarget == targetValue)
+        return;
+
+    targetValue = newTarget;
+
+    if (rampLengthInSamples <= 0)
+    {
+        setCurrentAndTargetValue(newTarget);
+        return;
+    }
+
+    stepsRemaining = rampLengthInSamples;
+    step = (targetValue - currentValue) / static_cast<float>(rampLengthInSamples);
+}
+
+void ParameterSmoother::setCurrentAndTargetValue(float newValue) noexcept
+{
+    currentValue = newValue;
+    targetValue = newValue;
+    stepsRemaining = 0;
+}
+
+const float* ParameterSmoother::process(int numSamples) noexcept
+{
+    jassert(numSamples <= static_cast<int>(values.size()));
+    numSamples = juce::jmin(numSamples, static_cast<int>(values.size()));
+
+    auto* dest = values.data();
+
+    // not smoothing, the whole block holds the target
+    if (stepsRemaining <= 0)
+    {
+        juce::FloatVectorOperations::fill(dest, targetValue, numSamples);
+        return dest;
+    }
+
+    const int rampSamples = juce::jmin(numSamples, stepsRemaining);
+
+    if (rampType == Linear)
+    {
+        for (int i = 0; i < rampSamples; ++i)
+            dest[i] = currentValue + step * static_cast<float>(i + 1);
+    }
+    else
+    {
+        const auto distance = currentValue - targetValue;
+        const auto* powers = decay.data();
+        for (int i = 0; i < rampSamples; ++i)
+            dest[i] = targetValue + distance * powers[i];
+    }
+
+    stepsRemaining -= rampSamples;
+
+    // the last ramp sample lands on the target exactly, the rest of the block
+    // holds it
+    if (stepsRemaining == 0)
+    {
+        dest[rampSamples - 1] = targetValue;
+        currentValue = targetValue;
+    }
+    else
+    {
+        currentValue = dest[rampSamples - 1];
+    }
+
+    if (rampSamples < numSamples)
+        juce::FloatVectorOperations::fill(dest + rampSamples, targetValue, numSamples - rampSamples);
+
+    return dest;
+}
@@ -0,0 +1,72 @@
+/**
+ * @file ParameterSmoother.h
+ * @brief Block-based parameter smoothing shared by all processors
+ *
+ * Turns per-block parameter updates into per-sample ramps. Each call to
+ * process() fills a preallocated buffer with the next numSamples values, so
+ * processors read the smoothed value straight from an array in their block
+ * loops instead of calling a smoother per sample. Both ramp types are
+ * computed without a loop-carried dependency, so the fills vectorise.
+ *
+ * @description
+ * Linear: Reaches the target in exactly rampLength seconds
+ * Exponential: One-pole approach to the target, rampLength is the time to get within ~-60 dB
+ */
+
+#pragma once
+
+#ifndef PARAMETERSMOOTHER_H
+#define PARAMETERSMOOTHER_H
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <vector>
+
+class ParameterSmoother
+{
+public:
+    enum RampType
+    {
+        Linear = 0,
+        Exponential = 1
+    };
+
+    ParameterSmoother() = default;
+
+    // allocate the block buffer and set the ramp length (allocates, so only
+    // call this from prepare)
+    void prepare(double sampleRate, int maximumBlockSize, double rampLengthSeconds, RampType type = Linear);
+
+    // start a ramp from the current value towards a new target
+    void setTargetValue(float newTarget) noexcept;
+
+    // jump straight to a value with no ramp
+    void setCurrentAndTargetValue(float newValue) noexcept;
+
+    [[nodiscard]] float getCurrentValue() const noexcept { return currentValue; }
+    [[nodiscard]] float getTargetValue() const noexcept { return targetValue; }
+    [[nodiscard]] bool isSmoothing() const noexcept { return stepsRemaining > 0; }
+
+    // fill the internal buffer with the next numSamples values and return it,
+    // numSamples must not exceed the block size passed to prepare
+    const float* process(int numSamples) noexcept;
+
+private:
+    RampType rampType = Linear;
+    int rampLengthInSamples = 0;
+
+    float currentValue = 0.0f;
+    float targetValue = 0.0f;
+    int stepsRemaining = 0;
+
+    // linear ramp increment per sample
+    float step = 0.0f;
+
+    // exponential ramp: decay[i] = coefficient^(i + 1), precomputed in prepare
+    std::vector<float> decay;
+
+    std::vector<float> values;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParameterSmoother)
+};
+
+#endif //PARAMETERSMOOTHER_H
@@ -0,0 +1,180 @@
+#include "RealtimeWorkerPool.h"
+
+#if JUCE_INTEL
+    #include <immintrin.h>
+#endif
+
+std::atomic<int> RealtimeWorkerPool::nextCore { 0 };
+
+RealtimeWorkerPool::RealtimeWorkerPool(int numWorkers, bool pinThreads)
+{
+    jassert(numWorkers >= 0);
+
+    // leave core 0, which usually also serves interrupts and the host's
+    // message thread, and carry on from where the last pool left off, so
+    // several instances spread over the cores instead of piling onto the same
+    // ones
+    const auto numCores = juce::jmax(1, juce::SystemStats::getNumCpus());
+    const auto firstCore = pinThreads ? nextCore.fetch_add(numWorkers) : 0;
+
+    for (int index = 0; index < numWorkers; ++index)
+    {
+        const auto core = pinThreads && numCores > 1 ? 1 + (firstCore + index) % (numCores - 1) : -1;
+        workers.add(new Worker(*this, core));
+    }
+
+    for (auto* worker : workers)
+    {
+        if (!worker->startRealtimeThread(juce::Thread::RealtimeOptions()))
+        {
+            // without real-time scheduling a worker could hold the audio
+            // thread up, so render everything on the caller instead
+            stopWorkers();
+            workers.clear();
+            break;
+        }
+    }
+}
+
+RealtimeWorkerPool::~RealtimeWorkerPool()
+{
+    stopWorkers();
+}
+
+void RealtimeWorkerPool::stopWorkers()
+{
+    for (auto* worker : workers)
+        worker->signalThreadShouldExit();
+
+    // sleeping workers check threadShouldExit once they're woken
+    wakeCounter.fetch_add(1);
+    wakeCounter.notify_all();
+
+    for (auto* worker : workers)
+        worker->stopThread(1000);
+}
+
+void RealtimeWorkerPool::run(Job job, void* context, int numJobs) noexcept
+{
+    jassert(numJobs <= maxJobs);
+
+    if (numJobs <= 0)
+        return;
+
+    // nobody to share a single job with
+    if (workers.isEmpty() || numJobs == 1)
+    {
+        for (int index = 0; index < numJobs; ++index)
+            job(context, index);
+        return;
+    }
+
+    // the previous batch has finished, so nobody reads these until the new
+    // claims word below is published
+    currentJob = job;
+    currentContext = context;
+    remaining.store(numJobs, std::memory_order_relaxed);
+
+    ++generation;
+    claims.store((static_cast<uint64_t>(generation) << 32) | static_cast<uint64_t>(numJobs));
+
+    // pairs with the sleeping worker's numSleeping increment, either it sees
+    // the new batch or we see it asleep
+    if (numSleeping.load() > 0)
+        wakeWorkers();
+
+    // work on the batch ourselves rather than just waiting for it
+    while (runNextJob(generation)) {}
+
+    // wait for the jobs the workers are still running
+    while (remaining.load(std::memory_order_acquire) != 0)
+        pause();
+}
+
+bool RealtimeWorkerPool::hasNewJobs(uint32_t lastBatch) const noexcept
+{
+    // sequentially consistent, see the sleep check in Worker::run
+    const auto word = claims.load();
+    return getGeneration(word) != lastBatch && getNextJob(word) < getJobCount(word);
+}
+
+bool RealtimeWorkerPool::runNextJob(uint32_t batch) noexcept
+{
+    auto word = claims.load(std::memory_order_acquire);
+
+    for (;;)
+    {
+        if (getGeneration(word) != batch || getNextJob(word) >= getJobCount(word))
+            return false;
+
+        if (claims.compare_exchange_weak(word, word + (1u << 16), std::memory_order_acq_rel, std::memory_order_acquire))
+            break;
+    }
+
+    // the batch can't finish (and the job change) before we've run this one
+    currentJob(currentContext, getNextJob(word));
+    remaining.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void RealtimeWorkerPool::wakeWorkers() noexcept
+{
+    // a futex/ulock wake, no mutex is involved
+    wakeCounter.fetch_add(1);
+    wakeCounter.notify_all();
+}
+
+void RealtimeWorkerPool::pause() noexcept
+{
+   #if JUCE_INTEL
+    _mm_pause();
+   #elif JUCE_ARM && (JUCE_GCC || JUCE_CLANG)
+    asm volatile ("yield");
+   #endif
+}
+
+//=Worker=======================================================================
+
+RealtimeWorkerPool::Worker::Worker(RealtimeWorkerPool& poolToUse, int coreToUse)
+    : juce::Thread("Realtime worker"), pool(poolToUse), core(coreToUse)
+{
+}
+
+void RealtimeWorkerPool::Worker::run()
+{
+    // the same float mode as the audio thread (PluginProcessor::processBlock),
+    // so a job renders the same whichever thread picks it up, and decaying
+    // state flushes to zero instead of going denormal
+    juce::ScopedNoDenormals noDenormals;
+
+    if (core >= 0)
+        juce::Thread::setCurrentThreadAffinityMask(1u << (core % 32));
+
+    // the batch this worker last helped with
+    uint32_t batch = 0;
+
+    while (!threadShouldExit())
+    {
+        // spin briefly, the next batch is usually one callback away
+        for (int spin = 0; spin < spinIterations && !pool.hasNewJobs(batch); ++spin)
+            pause();
+
+        if (!pool.hasNewJobs(batch))
+        {
+            // announce we're going to sleep before the final check, so run()
+            // either sees us asleep or we see its batch
+            const auto wakeValue = pool.wakeCounter.load();
+            pool.numSleeping.fetch_add(1);
+
+            if (!pool.hasNewJobs(batch) && !threadShouldExit())
+                pool.wakeCounter.wait(wakeValue);
+
+            pool.numSleeping.fetch_sub(1);
+            continue;
+        }
+
+        // help with the newest batch, skipping any we slept through
+        batch = getGeneration(pool.claims.load(std::memory_order_acquire));
+        while (pool.runNextJob(batch)) {}
+    }
+}
@@ -0,0 +1,110 @@
+/**
+ * @file RealtimeWorkerPool.h
+ * @brief Worker threads that help the audio thread render independent jobs within one callback
+ *
+ * run() hands a batch of jobs to the workers and works through the same batch
+ * on the calling thread, returning once every job has finished. Jobs are
+ * claimed through a single atomic word (generation, next job, job count), so
+ * handing a batch over takes no lock and no allocation. Workers spin for a
+ * moment after each batch, since the next stage of the same callback may
+ * have another one, then sleep on an atomic wait; the audio thread only
+ * issues a wake-up when a worker is actually asleep.
+ *
+ * If the system won't start a worker as a real-time thread, the pool starts
+ * none and run() does every job on the calling thread.
+ *
+ * Only one thread may call run() at a time (the audio thread that owns the
+ * pool). Jobs must not throw.
+ *
+ * @description
+ * numWorkers: Threads besides the caller that pick up jobs
+ * pinThreads: Whether each worker is pinned to a core, pools take turns so instances don't share cores
+ * spinIterations: Polls a worker makes after a batch before it goes to sleep
+ */
+
+#pragma once
+
+#ifndef REALTIMEWORKERPOOL_H
+#define REALTIMEWORKERPOOL_H
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <atomic>
+#include <cstdint>
+
+class RealtimeWorkerPool
+{
+public:
+    // a job is called with the context passed to run() and its index in the batch
+    using Job = void (*)(void* context, int index);
+
+    static constexpr int maxJobs = 0xffff;
+    static constexpr int spinIterations = 256;
+
+    // start the worker threads (allocates, not from the audio thread)
+    explicit RealtimeWorkerPool(int numWorkers, bool pinThreads = false);
+    ~RealtimeWorkerPool();
+
+    [[nodiscard]] int getNumWorkers() const noexcept { return workers.size(); }
+
+    // run job for every index in [0, numJobs) across the workers and the
+    // calling thread, returns once all of them have finished (real-time safe)
+    void run(Job job, void* context, int numJobs) noexcept;
+
+private:
+    class Worker : public juce::Thread
+    {
+    public:
+        Worker(RealtimeWorkerPool& poolToUse, int coreToUse);
+        void run() override;
+
+    private:
+        RealtimeWorkerPool& pool;
+        int core; // -1 if not pinned
+    };
+
+    // generation in the top 32 bits, then the next unclaimed job and the job
+    // count in 16 bits each. A worker can only claim a job from the batch it
+    // saw, so a late worker can never run a job from the next batch
+    std::atomic<uint64_t> claims { 0 };
+
+    // written by run() before the batch is published through claims
+    Job currentJob = nullptr;
+    void* currentContext = nullptr;
+    uint32_t generation = 0;
+
+    // jobs of the current batch that haven't finished yet
+    std::atomic<int> remaining { 0 };
+
+    // workers sleep on this word, run() bumps it to wake them
+    std::atomic<uint32_t> wakeCounter { 0 };
+    std::atomic<int> numSleeping { 0 };
+
+    juce::OwnedArray<Worker> workers;
+
+    // the core the next pinned worker of any pool goes to (minus one), so
+    // every instance's workers land on different cores
+    static std::atomic<int> nextCore;
+
+    static uint32_t getGeneration(uint64_t word) noexcept { return static_cast<uint32_t>(word >> 32); }
+    static int getNextJob(uint64_t word) noexcept { return static_cast<int>((word >> 16) & 0xffff); }
+    static int getJobCount(uint64_t word) noexcept { return static_cast<int>(word & 0xffff); }
+
+    // whether a batch newer than lastBatch still has a job nobody has claimed
+    [[nodiscard]] bool hasNewJobs(uint32_t lastBatch) const noexcept;
+
+    // claim and run one job of batch generation, false once there are none left
+    bool runNextJob(uint32_t batch) noexcept;
+
+    // wake any workers that have gone to sleep
+    void wakeWorkers() noexcept;
+
+    // ask every worker to exit and wait for the ones that are running
+    void stopWorkers();
+
+    // processor hint for spin-wait loops
+    static void pause() noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RealtimeWorkerPool)
+};
+
+#endif //REALTIMEWORKERPOOL_H
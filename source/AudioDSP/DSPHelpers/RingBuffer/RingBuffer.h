@@ -0,0 +1,178 @@
+/**
+ * @file RingBuffer.h
+ * @brief Multichannel circular buffer with power-of-two capacity
+ *
+ * The capacity is always rounded up to a power of two, so every index is
+ * wrapped with a single bitmask instead of branches or integer division.
+ * Positions can be absolute (any integer, wrapped on access) or relative to
+ * the write head as a delay in samples.
+ *
+ * Clearing is lazy (see LazyClear): markEmpty() is O(1), and touch() zeroes
+ * the stale pages of a region right before a block uses it. Any region has to
+ * be touched in the block before it's read or written through the accessors
+ * below, otherwise it may still hold samples from before the last clear.
+ *
+ * @description
+ * capacity: Number of samples per channel (power of two, >= requested size)
+ * writePosition: Index of the next sample to be written (always wrapped)
+ */
+
+#pragma once
+
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "../LazyClear/LazyClear.h"
+#include <cmath>
+
+template <typename SampleType>
+class RingBuffer
+{
+public:
+    RingBuffer() = default;
+
+    // allocate at least minimumCapacity samples per channel (rounded up to a
+    // power of two), allocates so call from prepare. The contents start out
+    // logically empty, and memory that's never touched is never zeroed
+    void setSize(int numChannels, int minimumCapacity)
+    {
+        jassert(numChannels > 0 && minimumCapacity > 0);
+
+        capacity = juce::nextPowerOfTwo(juce::jmax(2, minimumCapacity));
+        mask = capacity - 1;
+        buffer.setSize(numChannels, capacity);
+        pages.prepare(capacity, juce::jmin(LazyClear::defaultPageSize, capacity));
+        writePosition = 0;
+    }
+
+    // free the sample memory (allocates/frees, so not from the audio thread),
+    // setSize() brings it back
+    void release()
+    {
+        buffer.setSize(0, 0);
+        pages.release();
+        capacity = 0;
+        mask = 0;
+        writePosition = 0;
+    }
+
+    // make the contents logically empty in O(1) and move the write head back
+    // to the start, pages are zeroed as they're touched again
+    void markEmpty() noexcept
+    {
+        pages.markEmpty();
+        writePosition = 0;
+    }
+
+    // zero any stale pages in the absolute range [position, position + numSamples),
+    // which may wrap. Costs nothing once the range has been touched since the
+    // last markEmpty()
+    void touch(int position, int numSamples) noexcept
+    {
+        numSamples = juce::jmin(numSamples, capacity);
+        const int start = wrap(position);
+        const int firstPart = juce::jmin(numSamples, capacity - start);
+
+        const auto zeroRange = [this](int pageStart, int pageLength)
+        {
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                buffer.clear(channel, pageStart, pageLength);
+        };
+
+        pages.touch(start, firstPart, zeroRange);
+        if (firstPart < numSamples)
+            pages.touch(0, numSamples - firstPart, zeroRange);
+    }
+
+    [[nodiscard]] int getCapacity() const noexcept { return capacity; }
+    [[nodiscard]] int getMask() const noexcept { return mask; }
+    [[nodiscard]] int getNumChannels() const noexcept { return buffer.getNumChannels(); }
+    [[nodiscard]] int getWritePosition() const noexcept { return writePosition; }
+
+    // wrap any (possibly negative) index into the buffer
+    [[nodiscard]] int wrap(int index) const noexcept { return index & mask; }
+
+    // move the write head forward once a block has been written
+    void advanceWritePosition(int numSamples) noexcept { writePosition = wrap(writePosition + numSamples); }
+
+    // raw channel access for kernels that do their own masked indexing
+    SampleType* getWritePointer(int channel) noexcept { return buffer.getWritePointer(channel); }
+    const SampleType* getReadPointer(int channel) const noexcept { return buffer.getReadPointer(channel); }
+
+    // write a sample at an offset from the write head
+    void write(int channel, int offset, SampleType value) noexcept
+    {
+        buffer.getWritePointer(channel)[wrap(writePosition + offset)] = value;
+    }
+
+    // copy a block to the write head (the write head is not advanced)
+    void writeBlock(int channel, const SampleType* source, int numSamples) noexcept
+    {
+        jassert(numSamples <= capacity);
+
+        auto* data = buffer.getWritePointer(channel);
+        const int firstPart = juce::jmin(numSamples, capacity - writePosition);
+
+        juce::FloatVectorOperations::copy(data + writePosition, source, firstPart);
+        if (firstPart < numSamples)
+            juce::FloatVectorOperations::copy(data, source + firstPart, numSamples - firstPart);
+    }
+
+    // read the sample written delaySamples before the write head
+    [[nodiscard]] SampleType read(int channel, int delaySamples) const noexcept
+    {
+        return buffer.getReadPointer(channel)[wrap(writePosition - delaySamples)];
+    }
+
+    // read a fractional absolute position with linear interpolation
+    [[nodiscard]] SampleType readInterpolated(int channel, SampleType position) const noexcept
+    {
+        const auto* data = buffer.getReadPointer(channel);
+        const auto floored = std::floor(position);
+        const auto index = static_cast<int>(floored);
+        const auto frac = position - floored;
+        const auto a = data[wrap(index)];
+        const auto b = data[wrap(index + 1)];
+
+        return a + frac * (b - a);
+    }
+
+    // read numSamples fractional absolute positions, starting at startPosition
+    // and stepping by increment, with linear interpolation
+    void readInterpolated(int channel, SampleType startPosition, SampleType increment,
+                          SampleType* dest, int numSamples) const noexcept
+    {
+        const auto* data = buffer.getReadPointer(channel);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto position = startPosition + static_cast<SampleType>(i) * increment;
+            const auto floored = std::floor(position);
+            const auto index = static_cast<int>(floored);
+            const auto frac = position - floored;
+            const auto a = data[index & mask];
+            const auto b = data[(index + 1) & mask];
+
+            dest[i] = a + frac * (b - a);
+        }
+    }
+
+    // wrap a fractional absolute position into [0, capacity)
+    [[nodiscard]] SampleType wrapPosition(SampleType position) const noexcept
+    {
+        const auto size = static_cast<SampleType>(capacity);
+        return position - std::floor(position / size) * size;
+    }
+
+private:
+    juce::AudioBuffer<SampleType> buffer;
+    LazyClear pages;
+    int capacity = 0;
+    int mask = 0;
+    int writePosition = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RingBuffer)
+};
+
+#endif //RINGBUFFER_H
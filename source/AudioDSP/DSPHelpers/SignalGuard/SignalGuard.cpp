@@ -0,0 +1,45 @@
+#include "SignalGuard.h"
+#include <bit>
+
+SignalGuard::Result SignalGuard::check(const juce::dsp::AudioBlock<float>& block, const KernelDispatch::Kernels& kernels) noexcept
+{
+    const auto found = scan(block, kernels);
+
+    if (!found.isFinite() || found.getPeak() > runawayLevel)
+        return tripped;
+
+    if (!found.hasDenormals)
+        return clean;
+
+    if (found.getPeak() < SilenceDetector::silenceLevel)
+        return tripped;
+
+    flushDenormals(block);
+    return flushed;
+}
+
+KernelDispatch::BlockScan SignalGuard::scan(const juce::dsp::AudioBlock<float>& block, const KernelDispatch::Kernels& kernels) noexcept
+{
+    KernelDispatch::BlockScan found;
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+
+    for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+        found.merge(kernels.scan(block.getChannelPointer(channel), numSamples));
+
+    return found;
+}
+
+void SignalGuard::flushDenormals(const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    const auto numSamples = block.getNumSamples();
+
+    // compare the bits, fast math may treat a denormal as zero in a float
+    // compare and leave it in place
+    for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+    {
+        auto* samples = block.getChannelPointer(channel);
+        for (size_t i = 0; i < numSamples; ++i)
+            if ((std::bit_cast<juce::uint32>(samples[i]) & 0x7fffffffu) < 0x00800000u)
+                samples[i] = 0.0f;
+    }
+}
@@ -0,0 +1,58 @@
+/**
+ * @file SignalGuard.h
+ * @brief Catches NaNs, infinities, runaway feedback and denormals in a processed block
+ *
+ * The execution plan checks every processor's block right after it runs, so
+ * a processor that has blown up is caught before its output reaches the next
+ * one, and only that processor is reset. One vectorised pass over each
+ * channel (KernelDispatch::Kernels::scan) finds the peak and any denormals
+ * from the bits of the samples, which works under fast math where isnan and
+ * isinf don't.
+ *
+ * A block trips the guard if it holds a NaN or infinity, or peaks above
+ * runawayLevel, which only a feedback loop that has run away gets to. A block
+ * that's all below SilenceDetector::silenceLevel and has denormals in it
+ * trips it too: the processor is ringing out into the denormal range, and
+ * resetting it can't be heard. Denormals in a louder block are only flushed
+ * to zero.
+ *
+ * @description
+ * runawayLevel: Peak above which a block counts as runaway (+60 dBFS)
+ * clean: Nothing to do
+ * flushed: The block had denormals, they've been set to zero
+ * tripped: The processor that rendered the block needs resetting, and the block clearing
+ */
+
+#pragma once
+
+#ifndef SIGNALGUARD_H
+#define SIGNALGUARD_H
+
+#include <juce_dsp/juce_dsp.h>
+#include "../KernelDispatch/KernelDispatch.h"
+#include "../SilenceDetector/SilenceDetector.h"
+
+class SignalGuard
+{
+public:
+    static constexpr float runawayLevel = 1000.0f; // +60 dBFS
+
+    enum Result
+    {
+        clean,
+        flushed,
+        tripped
+    };
+
+    // check a block, flushing its denormals unless it trips (real-time safe)
+    [[nodiscard]] static Result check(const juce::dsp::AudioBlock<float>& block, const KernelDispatch::Kernels& kernels) noexcept;
+
+    // the peak and denormals of every channel of a block
+    [[nodiscard]] static KernelDispatch::BlockScan scan(const juce::dsp::AudioBlock<float>& block, const KernelDispatch::Kernels& kernels) noexcept;
+
+private:
+    // set every denormal in the block to zero
+    static void flushDenormals(const juce::dsp::AudioBlock<float>& block) noexcept;
+};
+
+#endif //SIGNALGUARD_H
@@ -0,0 +1,50 @@
+#include "SilenceDetector.h"
+
+void SilenceDetector::reset() noexcept
+{
+    peakLevel = 0.0f;
+    samplesSinceInput = 0;
+    sleeping = true;
+}
+
+juce::int64 SilenceDetector::getDecaySamples(float level, float gain, double stepSamples) noexcept
+{
+    if (level < silenceLevel || gain <= 0.0f)
+        return 0;
+
+    if (gain >= 1.0f)
+        return endlessTail;
+
+    // level * gain^steps < silenceLevel
+    const auto steps = std::ceil(std::log(static_cast<double>(silenceLevel) / level) / std::log(static_cast<double>(gain)));
+    const auto samples = std::ceil(steps * stepSamples);
+
+    // a feedback a hair below 1 rings for longer than anyone will wait
+    if (samples >= static_cast<double>(endlessTail / 2))
+        return endlessTail;
+
+    return static_cast<juce::int64>(samples);
+}
+
+double SilenceDetector::toSeconds(juce::int64 tailSamples, double sampleRate) noexcept
+{
+    if (tailSamples == endlessTail)
+        return longestTailSeconds;
+
+    return juce::jmin(longestTailSeconds, static_cast<double>(tailSamples) / sampleRate);
+}
+
+float SilenceDetector::getPeak(const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    float peak = 0.0f;
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+
+    for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+    {
+        float low, high;
+        juce::FloatVectorOperations::findMinAndMax(block.getChannelPointer(channel), numSamples, low, high);
+        peak = juce::jmax(peak, -low, high);
+    }
+
+    return peak;
+}
@@ -0,0 +1,109 @@
+/**
+ * @file SilenceDetector.h
+ * @brief Lets a processor skip its blocks once its input and its own tail have both gone silent
+ *
+ * A processor hands every block to process() before it changes it. A block
+ * peaking at silenceLevel or above wakes the processor and restarts its tail.
+ * After that, silent blocks count down the tail the processor works out from
+ * its own state for the loudest input it's had (echoes left in a delay line,
+ * a reverb's decay, grains still reading the delay buffer). Once the count
+ * passes the tail the processor's output can only be below silenceLevel too,
+ * so it skips its blocks entirely until the input comes back. On a large
+ * session that's most blocks of most instances.
+ *
+ * The tail is only asked for while the input is silent, so it can walk the
+ * processor's state without costing anything while there's signal.
+ *
+ * A processor clears what's left of its state (all of it below silenceLevel)
+ * as it falls asleep, so it wakes up just as it would from a reset.
+ *
+ * @description
+ * silenceLevel: Peak level below which input and tails count as silent (-100 dB)
+ * endlessTail: Tail of a processor that never dies away (a frozen reverb, a playing loop), it never sleeps
+ * longestTailSeconds: Longest tail reported to the host, endless ones included (we build with fast math, which can't test for infinity)
+ */
+
+#pragma once
+
+#ifndef SILENCEDETECTOR_H
+#define SILENCEDETECTOR_H
+
+#include <juce_dsp/juce_dsp.h>
+#include <limits>
+
+class SilenceDetector
+{
+public:
+    static constexpr float silenceLevel = 1.0e-5f; // -100 dB
+    static constexpr juce::int64 endlessTail = std::numeric_limits<juce::int64>::max();
+    static constexpr double longestTailSeconds = 60.0;
+
+    enum State
+    {
+        awake,         // process the block
+        fallingAsleep, // skip the block, and clear what's left of the tail
+        asleep         // skip the block
+    };
+
+    SilenceDetector() = default;
+
+    // forget the input, a processor that's just been reset has nothing left
+    // to ring out
+    void reset() noexcept;
+
+    // measure a block of input and count it towards the tail (audio thread).
+    // getTailSamples(level) returns how many samples the processor rings for
+    // after input peaking at level, it's only called for silent blocks
+    template <typename TailFunction>
+    State process(const juce::dsp::AudioBlock<float>& input, TailFunction&& getTailSamples) noexcept
+    {
+        const auto numSamples = static_cast<juce::int64>(input.getNumSamples());
+        const auto peak = getPeak(input);
+
+        if (peak >= silenceLevel)
+        {
+            peakLevel = juce::jmax(peakLevel, peak);
+            samplesSinceInput = 0;
+            sleeping = false;
+            return awake;
+        }
+
+        if (sleeping)
+            return asleep;
+
+        if (samplesSinceInput < getTailSamples(peakLevel))
+        {
+            samplesSinceInput += numSamples;
+            return awake;
+        }
+
+        sleeping = true;
+        peakLevel = 0.0f;
+        return fallingAsleep;
+    }
+
+    [[nodiscard]] bool isAsleep() const noexcept { return sleeping; }
+
+    // samples for a level to fall below silenceLevel when it's multiplied by
+    // gain every stepSamples (endlessTail if it never does)
+    [[nodiscard]] static juce::int64 getDecaySamples(float level, float gain, double stepSamples) noexcept;
+
+    // a tail in seconds for the host, up to longestTailSeconds
+    [[nodiscard]] static double toSeconds(juce::int64 tailSamples, double sampleRate) noexcept;
+
+private:
+    // loudest input since the processor was last asleep
+    float peakLevel = 0.0f;
+
+    // samples processed since the last block with input
+    juce::int64 samplesSinceInput = 0;
+
+    // a processor starts out with nothing to ring out
+    bool sleeping = true;
+
+    [[nodiscard]] static float getPeak(const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SilenceDetector)
+};
+
+#endif //SILENCEDETECTOR_H
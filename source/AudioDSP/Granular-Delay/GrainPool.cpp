@@ -0,0 +1,51 @@
+#include "GrainPool.h"
+
+void GrainPool::allocate(int newCapacity)
+{
+    jassert(newCapacity > 0);
+    capacity = juce::jmax(1, newCapacity);
+
+    const auto size = static_cast<size_t>(capacity);
+    readPosition.assign(size, 0.0f);
+    pitchRatio.assign(size, 1.0f);
+    amplitude.assign(size, 0.0f);
+    currentSample.assign(size, 0);
+    totalSamples.assign(size, 0);
+    startOffset.assign(size, 0);
+    position.assign(size, 0.0f);
+
+    activeList.assign(size, 0);
+    freeList.assign(size, 0);
+
+    clear();
+}
+
+void GrainPool::clear() noexcept
+{
+    numActive = 0;
+    numFree = capacity;
+
+    // fill the stack so the lowest indices are handed out first
+    for (int i = 0; i < capacity; ++i)
+        freeList[static_cast<size_t>(i)] = capacity - 1 - i;
+}
+
+int GrainPool::spawn() noexcept
+{
+    // if all grains are active, do nothing (or could replace oldest)
+    if (numFree == 0)
+        return -1;
+
+    const int grain = freeList[static_cast<size_t>(--numFree)];
+    activeList[static_cast<size_t>(numActive++)] = grain;
+    return grain;
+}
+
+void GrainPool::retire(int activeSlot) noexcept
+{
+    jassert(juce::isPositiveAndBelow(activeSlot, numActive));
+
+    const int grain = activeList[static_cast<size_t>(activeSlot)];
+    activeList[static_cast<size_t>(activeSlot)] = activeList[static_cast<size_t>(--numActive)];
+    freeList[static_cast<size_t>(numFree++)] = grain;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file GrainPool.h
+ * @brief Structure-of-arrays grain pool with a dense active list
+ *
+ * Holds the per-grain state for the GranularProcessor as parallel arrays,
+ * along with a dense list of active grain indices and a free-list stack.
+ * Spawning and retiring a grain are both O(1), and iterating the active list
+ * only touches live grains, so the cost per block scales with the number of
+ * grains playing rather than the pool capacity.
+ *
+ * @description
+ * capacity: Maximum number of simultaneous grains, set in allocate()
+ */
+
+#pragma once
+
+#ifndef GRAINPOOL_H
+#define GRAINPOOL_H
+
+#include <juce_core/juce_core.h>
+#include <vector>
+
+class GrainPool
+{
+public:
+    GrainPool() = default;
+
+    // allocate storage for the given number of grains and retire all of them
+    // (allocates, so only call this from prepare)
+    void allocate(int newCapacity);
+
+    // retire every grain and rebuild the free list
+    void clear() noexcept;
+
+    // take a grain from the free list and add it to the active list, returns
+    // the grain index or -1 if the pool is full
+    int spawn() noexcept;
+
+    // retire the grain at the given position in the active list, the last
+    // active grain is moved into its place
+    void retire(int activeSlot) noexcept;
+
+    // active list access
+    [[nodiscard]] int getNumActive() const noexcept { return numActive; }
+    [[nodiscard]] int getActiveGrain(int activeSlot) const noexcept { return activeList[static_cast<size_t>(activeSlot)]; }
+    [[nodiscard]] int getCapacity() const noexcept { return capacity; }
+
+    // per-grain state, indexed by the grain index returned from spawn()
+    std::vector<float> readPosition;    // current read position (for pitch shift)
+    std::vector<float> pitchRatio;      // pitch ratio for grain playback
+    std::vector<float> amplitude;       // amplitude of the grain
+    std::vector<int> currentSample;     // current sample index in the grain
+    std::vector<int> totalSamples;      // total grain length in samples
+    std::vector<int> startOffset;       // sample offset in the current block where the grain starts
+    std::vector<float> position;        // place around the output channels (0 - 1), for scatter
+
+private:
+    std::vector<int> activeList;        // dense list of active grain indices
+    std::vector<int> freeList;          // stack of free grain indices
+
+    int capacity = 0;
+    int numActive = 0;
+    int numFree = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GrainPool)
+};
+
+#endif //GRAINPOOL_H
@@ -0,0 +1,93 @@
+#include "GrainWindowTables.h"
+
+void GrainWindowTables::prepare()
+{
+    for (int type = 0; type < numWindowTypes; ++type)
+    {
+        auto& table = tables[type];
+        table.resize(static_cast<size_t>(tableSize + 1));
+
+        for (int i = 0; i <= tableSize; ++i)
+        {
+            const auto phase = static_cast<float>(i) / static_cast<float>(tableSize);
+            table[static_cast<size_t>(i)] = computeWindow(static_cast<WindowType>(type), phase);
+        }
+    }
+}
+
+void GrainWindowTables::fillEnvelope(WindowType type, float startPhase, float phaseIncrement,
+                                     float gain, float* dest, int num) const noexcept
+{
+    const auto& table = tables[type];
+    jassert(table.size() == static_cast<size_t>(tableSize + 1)); // prepare() hasn't been called
+
+    const auto* data = table.data();
+    const auto scale = static_cast<float>(tableSize);
+    const auto start = startPhase * scale;
+    const auto increment = phaseIncrement * scale;
+
+    for (int i = 0; i < num; ++i)
+    {
+        const auto position = juce::jlimit(0.0f, scale, start + static_cast<float>(i) * increment);
+        const int index = juce::jmin(static_cast<int>(position), tableSize - 1);
+        const float frac = position - static_cast<float>(index);
+
+        dest[i] = (data[index] + frac * (data[index + 1] - data[index])) * gain;
+    }
+}
+
+float GrainWindowTables::getValue(WindowType type, float phase) const noexcept
+{
+    float value = 0.0f;
+    fillEnvelope(type, phase, 0.0f, 1.0f, &value, 1);
+    return value;
+}
+
+float GrainWindowTables::computeWindow(WindowType type, float phase)
+{
+    constexpr auto twoPi = juce::MathConstants<float>::twoPi;
+    phase = juce::jlimit(0.0f, 1.0f, phase);
+
+    switch (type)
+    {
+        case Hann:
+            return 0.5f * (1.0f - std::cos(twoPi * phase));
+
+        case Tukey:
+        {
+            // cosine tapers over the first and last 25% of the grain
+            constexpr float taper = 0.25f;
+            if (phase < taper)
+                return 0.5f * (1.0f - std::cos(juce::MathConstants<float>::pi * phase / taper));
+            if (phase > 1.0f - taper)
+                return 0.5f * (1.0f - std::cos(juce::MathConstants<float>::pi * (1.0f - phase) / taper));
+            return 1.0f;
+        }
+
+        case Gaussian:
+        {
+            // sigma is relative to the grain length, the bell is shifted down
+            // by its edge value and rescaled so the grain starts and ends at zero
+            const auto bell = [] (float x) { return std::exp(-0.5f * juce::square((x - 0.5f) / 0.15f)); };
+            const auto edge = bell(0.0f);
+            return juce::jmax(0.0f, (bell(phase) - edge) / (1.0f - edge));
+        }
+
+        case Trapezoid:
+        {
+            constexpr float ramp = 0.25f;
+            return juce::jmin(1.0f, phase / ramp, (1.0f - phase) / ramp);
+        }
+
+        case BlackmanHarris:
+            return 0.35875f
+                - 0.48829f * std::cos(twoPi * phase)
+                + 0.14128f * std::cos(2.0f * twoPi * phase)
+                - 0.01168f * std::cos(3.0f * twoPi * phase);
+
+        case numWindowTypes:
+        default:
+            jassertfalse; // unexpected window type
+            return 0.0f;
+    }
+}
@@ -0,0 +1,64 @@
+/**
+ * @file GrainWindowTables.h
+ * @brief Precomputed grain envelope tables
+ *
+ * Holds one lookup table per grain window shape, computed in prepare() so the
+ * grain renderer never has to call transcendental functions per sample.
+ * Tables are read by phase (0.0 - 1.0) with linear interpolation.
+ *
+ * @description
+ * Hann: Raised cosine, the original grain window
+ * Tukey: Flat top with cosine tapers over the outer 25% on each side
+ * Gaussian: Gaussian bell, shifted and rescaled so it reaches zero at the edges
+ * Trapezoid: Linear 25% fade in and out with a flat top
+ * BlackmanHarris: 4-term Blackman-Harris, the narrowest and smoothest envelope
+ */
+
+#pragma once
+
+#ifndef GRAINWINDOWTABLES_H
+#define GRAINWINDOWTABLES_H
+
+#include <juce_core/juce_core.h>
+#include <vector>
+
+class GrainWindowTables
+{
+public:
+    // window shapes, must match the choices in the grainWindow parameter
+    enum WindowType
+    {
+        Hann = 0,
+        Tukey = 1,
+        Gaussian = 2,
+        Trapezoid = 3,
+        BlackmanHarris = 4,
+        numWindowTypes
+    };
+
+    GrainWindowTables() = default;
+
+    // compute every table (allocates, so only call this from prepare)
+    void prepare();
+
+    // fill dest with window values for num samples, starting at startPhase and
+    // advancing by phaseIncrement each sample, scaled by gain
+    void fillEnvelope(WindowType type, float startPhase, float phaseIncrement,
+                      float gain, float* dest, int num) const noexcept;
+
+    // read a single value from a table by phase (0.0 - 1.0)
+    [[nodiscard]] float getValue(WindowType type, float phase) const noexcept;
+
+    // number of table segments, each table holds tableSize + 1 points so the
+    // interpolation never has to wrap
+    static constexpr int tableSize = 2048;
+
+private:
+    std::vector<float> tables[numWindowTypes];
+
+    static float computeWindow(WindowType type, float phase);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GrainWindowTables)
+};
+
+#endif //GRAINWINDOWTABLES_H
@@ -19,10 +19,48 @@ void GranularProcessor::prepare(const juce::dsp::ProcessSpec& spec)
     sampleRate = spec.sampleRate;
 
     // calculate buffer size for max delay in samples
-    bufferSize = static_cast<int>(sampleRate * 5.0f); // 5 seconds max delay
+    maxDelaySamples = static_cast<int>(sampleRate * 5.0); // 5 seconds max delay
 
-    // prepare AudioBuffer for delay
-    delayBuffer.setSize(2, bufferSize); // allocate for a stereo buffer
+    // prepare the ring buffer for delay, rounded up to a power of two, with a
+    // line per channel
+    const auto numChannels = static_cast<int>(spec.numChannels);
+    delayBuffer.setSize(numChannels, maxDelaySamples);
+
+    // build the grain window and interpolation tables
+    windowTables.prepare();
+    sincTable.prepare();
+
+    // pick the kernels for the widest instruction set this CPU runs
+    kernels = &KernelDispatch::getKernels(KernelDispatch::selectIsa());
+
+    // allocate the grain pool at the requested capacity
+    grains.allocate(maxGrains);
+
+    // allocate block-sized scratch space for the grain renderer
+    maxBlockSize = static_cast<int>(spec.maximumBlockSize);
+    wetBuffer.setSize(numChannels, maxBlockSize);
+    grainScratch.setSize(numScratchChannels, maxBlockSize);
+    grainIndices.assign(static_cast<size_t>(maxBlockSize), 0);
+
+    // lay out the scatter ring, without a layout (or one that doesn't match)
+    // every channel is a speaker
+    const auto hasLayout = channelLayout.size() == numChannels;
+    const auto isAmbisonic = hasLayout && channelLayout.getAmbisonicOrder() >= 0;
+    ringPlaces.assign(static_cast<size_t>(numChannels), -1);
+    ringSize = 0;
+
+    for (int channel = 0; channel < numChannels && !isAmbisonic; ++channel)
+    {
+        const auto type = hasLayout ? channelLayout.getTypeOfChannel(channel) : juce::AudioChannelSet::unknown;
+        if (type != juce::AudioChannelSet::LFE && type != juce::AudioChannelSet::LFE2)
+            ringPlaces[static_cast<size_t>(channel)] = ringSize++;
+    }
+
+    // prepare the parameter smoothers, starting at the current values
+    feedbackSmoother.prepare(sampleRate, maxBlockSize, gainRampSeconds);
+    wetDrySmoother.prepare(sampleRate, maxBlockSize, gainRampSeconds);
+    feedbackSmoother.setCurrentAndTargetValue(juce::jlimit(0.0f, 0.95f, granularParams.feedback));
+    wetDrySmoother.setCurrentAndTargetValue(granularParams.wetDryMix);
 
     // reset to clear buffers and vectors
     reset();
@@ -30,236 +68,392 @@ void GranularProcessor::prepare(const juce::dsp::ProcessSpec& spec)
 
 void GranularProcessor::reset()
 {
-    // clear delay buffer
-    delayBuffer.clear();
-    writePos = 0;
+    // forget the delay buffer contents (O(1), pages are zeroed as they're
+    // touched again)
+    delayBuffer.markEmpty();
 
-    // preallocate grain pool and mark all as inactive
+    // retire all grains (the pool itself is allocated in prepare)
     grains.clear();
-    for (int i = 0; i < maxGrains; ++i)
-    {
-        Grain g;
-        g.active = false;
-        grains.add(g);
-    }
+    silenceDetector.reset();
 
     // reset grain trigger timer and update grain timing
     updateGrainTiming();
     grainTriggerTimer = 0.0f;
 }
 
+void GranularProcessor::releaseResources()
+{
+    delayBuffer.release();
+    wetBuffer.setSize(0, 0);
+    grainScratch.setSize(0, 0);
+    std::vector<int>().swap(grainIndices);
+    std::vector<int>().swap(ringPlaces);
+    ringSize = 0;
+    grains.clear();
+
+    // process() refuses to run until we're prepared again
+    maxBlockSize = 0;
+}
+
 void GranularProcessor::process(const juce::dsp::ProcessContextReplacing<float>& context)
 {
-    if (context.getOutputBlock().getNumChannels() != 0)
-    {
-        DBG("Signal has hit the GranularProcessor!");
-    }
     if (!context.isBypassed)
     {
-        DBG("Signal was not bypassed at the GranularProcessor");
-        auto& inputBlock = context.getInputBlock();
+        // the scratch buffers are sized in prepare, so we can't render before that
+        jassert(maxBlockSize > 0);
+        if (maxBlockSize <= 0)
+            return;
+
         auto& outputBlock = context.getOutputBlock();
+        const auto numSamples = outputBlock.getNumSamples();
+        const auto chunkSize = static_cast<size_t>(maxBlockSize);
 
-        const auto numChannels = juce::jmin(
-            inputBlock.getNumChannels(),
-            outputBlock.getNumChannels(),
-            static_cast<size_t> (2)
-        );
+        // skip the block while the input and the grains are both silent
+        const auto silence = silenceDetector.process(outputBlock,
+            [this](float level) { return getTailSamples(level); });
 
+        if (silence != SilenceDetector::awake)
+        {
+            // what's left in the delay buffer is below the silence level, so
+            // retire the grains and wake up from empty
+            if (silence == SilenceDetector::fallingAsleep)
+                reset();
+
+            // nothing to ramp while we're asleep, so wake up at the targets
+            feedbackSmoother.setCurrentAndTargetValue(feedbackSmoother.getTargetValue());
+            wetDrySmoother.setCurrentAndTargetValue(wetDrySmoother.getTargetValue());
+
+            // the silent input is already the dry signal, and a send renders nothing
+            if (wetOnly)
+                outputBlock.clear();
+            return;
+        }
 
-        const auto numSamples = inputBlock.getNumSamples();
+        // pick the kernels for the channel count once per block, so mono and
+        // stereo grain rendering has no channel checks, wider layouts use the
+        // general kernels (the delay buffer has a line for each prepared channel)
+        const auto numChannels = juce::jmin(outputBlock.getNumChannels(),
+            static_cast<size_t>(delayBuffer.getNumChannels()));
 
-        for (int i = 0; i < static_cast<int>(numSamples); ++i)
+        // render in chunks no larger than the scratch buffers (normally just one)
+        for (size_t start = 0; start < numSamples; start += chunkSize)
         {
-            // read clean signal
-            float inputL = inputBlock.getSample(0, i);
-            float inputR;
+            const auto chunk = outputBlock.getSubBlock(start, juce::jmin(chunkSize, numSamples - start));
 
-            // handle mono and stereo signals
-            if (numChannels > 1)
-                inputR = inputBlock.getSample (1, i);
+            if (numChannels == 1)
+                processChunk<1>(chunk);
+            else if (numChannels == 2)
+                processChunk<2>(chunk);
             else
-                inputR = inputL;
-
-            // store clean signal for mixing later
-            float cleanL = inputL;
-            float cleanR = inputR;
-
-            // check if we should trigger new grains
-            grainTriggerTimer += 1.0f;
-            if (grainTriggerTimer >= samplesPerGrainTrigger)
-            {
-                triggerNewGrain();
-                grainTriggerTimer = 0.0f;
-            }
-
-            // process all active grains to get delayed signal
-            // also handle stereo channels
-            float delayedL = processActiveGrains(0);
-            float delayedR;
-            if (numChannels > 1)
-                delayedR = processActiveGrains (1);
-            else
-                delayedR = processActiveGrains (0);
-
-            // write input + feedback to delay buffer
-            float feedbackL = delayBuffer.getSample(0, (writePos - 1 + bufferSize) % bufferSize);
-            float safeFeedback = juce::jlimit(0.0f, 0.95f, granularParams.feedback);
-            delayBuffer.setSample(0,
-                writePos,
-                inputL + (feedbackL * safeFeedback)
-            );
-
-            if (numChannels > 1)
-            {
-                float feedbackR = delayBuffer.getSample(1, (writePos - 1 + bufferSize) % bufferSize);
-                delayBuffer.setSample(1,
-                    writePos,
-                    inputR + (feedbackR * safeFeedback)
-                );
-            }
-            else
-            {
-                delayBuffer.setSample(1,
-                    writePos,
-                    inputL + (feedbackL * safeFeedback)
-                );
-            }
-
-            // mix clean and delayed signals
-            float outputL = (delayedL * granularParams.wetDryMix) + (cleanL * (1.0f - granularParams.wetDryMix));
-            float outputR = (delayedR * granularParams.wetDryMix) + (cleanR * (1.0f - granularParams.wetDryMix));
-
-            // write output to the output block
-            outputBlock.setSample(0, i, outputL);
-            if (numChannels > 1)
-            {
-                outputBlock.setSample(1, i, outputR);
-            }
-
-            // advance write position in the delay buffer
-            writePos = (writePos + 1) % bufferSize;
+                processChunk<anyChannels>(chunk.getSubsetChannelBlock(0, numChannels));
         }
     }
-    else DBG("Signal was bypassed at the GranularProcessor");
-
 }
 
-void GranularProcessor::updateParameters(const GranularParams& params)
+template <int numChannels>
+void GranularProcessor::processChunk(const juce::dsp::AudioBlock<float>& block)
 {
-    granularParams = params;
-    // ensure grainDensity is always positive and reasonable
-    granularParams.grainDensity = juce::jlimit(0.01f, 100.0f, granularParams.grainDensity);
-    granularParams.grainSize = juce::jlimit(0.001f, 2.0f, granularParams.grainSize);
-    updateGrainTiming();
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+
+    // fixed at compile time for mono and stereo, so the channel loops unroll
+    const auto channelCount = numChannels != anyChannels ? numChannels : static_cast<int>(block.getNumChannels());
+
+    // fill the per-sample parameter ramps for this chunk
+    const auto* feedbacks = feedbackSmoother.process(numSamples);
+    const auto* wetDryMixes = wetDrySmoother.process(numSamples);
+
+    // write input + feedback for the whole chunk first, so each grain can then
+    // be read out of the delay buffer in a single pass
+    writeToDelayBuffer<numChannels>(block, feedbacks);
+
+    // spawn the grains that are due within this chunk, then render every
+    // active grain across the chunk into the wet buffer
+    scheduleGrains(numSamples);
+    renderGrains<numChannels>(numSamples, channelCount);
+
+    // mix clean and delayed signals (the block still holds the clean input),
+    // or replace the clean signal when a send stage mixes it in instead
+    for (int channel = 0; channel < channelCount; ++channel)
+    {
+        auto* output = block.getChannelPointer(static_cast<size_t>(channel));
+        const auto* wet = wetBuffer.getReadPointer(channel);
+
+        if (wetOnly)
+        {
+            juce::FloatVectorOperations::multiply(output, wet, wetDryMixes, numSamples);
+            continue;
+        }
+
+        kernels->mix(output, wet, wetDryMixes, numSamples);
+    }
+
+    // advance write position in the delay buffer
+    delayBuffer.advanceWritePosition(numSamples);
 }
 
-void GranularProcessor::triggerNewGrain()
+template <int numChannels>
+void GranularProcessor::writeToDelayBuffer(const juce::dsp::AudioBlock<float>& block, const float* feedbacks)
 {
-    // find an inactive grain to reuse
-    for (int i = 0; i < grains.size(); ++i)
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+    const auto channelCount = numChannels != anyChannels ? numChannels : static_cast<int>(block.getNumChannels());
+
+    // the chunk plus the previous sample, which feeds back into the first one
+    delayBuffer.touch(delayBuffer.getWritePosition() - 1, numSamples + 1);
+
+    // only the block's channels are written, the renderer never reads the
+    // lines past them
+    for (int channel = 0; channel < channelCount; ++channel)
     {
-        if (!grains.getReference(i).active)
+        const auto* input = block.getChannelPointer(static_cast<size_t>(channel));
+        auto* delayData = delayBuffer.getWritePointer(channel);
+        const auto mask = delayBuffer.getMask();
+        const auto writePos = delayBuffer.getWritePosition();
+
+        // feedback is taken from the previously written sample
+        float previous = delayBuffer.read(channel, 1);
+
+        for (int i = 0; i < numSamples; ++i)
         {
-            resetGrain(grains.getReference(i));
-            return;
+            previous = input[i] + (previous * feedbacks[i]);
+            delayData[(writePos + i) & mask] = previous;
         }
     }
-    // If all grains are active, do nothing (or could replace oldest)
 }
 
-void GranularProcessor::updateGrainTiming()
+void GranularProcessor::scheduleGrains(int numSamples)
 {
-    samplesPerGrainTrigger = static_cast<float>(sampleRate / granularParams.grainDensity);
+    // a grain is triggered on the sample where the timer reaches the trigger
+    // interval, after which the timer restarts from zero
+    auto triggerOffset = juce::jmax(0, static_cast<int>(std::ceil(samplesPerGrainTrigger - grainTriggerTimer)) - 1);
+    const auto triggerInterval = juce::jmax(1, static_cast<int>(std::ceil(samplesPerGrainTrigger)));
+    int lastTrigger = -1;
+
+    while (triggerOffset < numSamples)
+    {
+        triggerNewGrain(triggerOffset);
+        lastTrigger = triggerOffset;
+        triggerOffset += triggerInterval;
+    }
+
+    if (lastTrigger >= 0)
+        grainTriggerTimer = static_cast<float>(numSamples - 1 - lastTrigger);
+    else
+        grainTriggerTimer += static_cast<float>(numSamples);
 }
 
-float GranularProcessor::processActiveGrains(int channel)
+template <int numChannels>
+void GranularProcessor::renderGrains(int numSamples, int channelCount)
 {
-    float output = 0.0f;
+    for (int channel = 0; channel < channelCount; ++channel)
+        juce::FloatVectorOperations::clear(wetBuffer.getWritePointer(channel), numSamples);
 
-    // process each active grain
-    for (auto& grain : grains)
+    // render each active grain across the whole chunk, retiring finished
+    // grains as we go (retire moves the last active grain into this slot)
+    for (int slot = 0; slot < grains.getNumActive();)
     {
-        if (!grain.active || grain.currentSample >= grain.totalSamples)
-        {
-            grain.active = false;
-        }
+        if (renderGrain<numChannels>(grains.getActiveGrain(slot), numSamples, channelCount))
+            ++slot;
+        else
+            grains.retire(slot);
+    }
+}
 
-        // apply window based on grain position within its length
-        float grainPhase = static_cast<float>(grain.currentSample) / static_cast<float>(grain.totalSamples);
-        float envelope = applyWindow(grainPhase);
+template <int numChannels>
+bool GranularProcessor::renderGrain(int grain, int numSamples, int channelCount)
+{
+    // the block's count only matters for the general kernels
+    if constexpr (numChannels != anyChannels)
+        channelCount = numChannels;
+
+    const auto g = static_cast<size_t>(grain);
+    const int start = grains.startOffset[g];
+    const int length = juce::jmin(numSamples - start, grains.totalSamples[g] - grains.currentSample[g]);
+
+    // grains carried over into the next chunk start at its first sample
+    grains.startOffset[g] = 0;
+
+    if (length <= 0)
+        return false;
+
+    auto* envelope = grainScratch.getWritePointer(envelopeScratch);
+    auto* fractions = grainScratch.getWritePointer(fractionScratch);
+    auto* indices = grainIndices.data();
+    auto* gathered = grainScratch.getWritePointer(gatherScratch);
+
+    const auto currentSample = grains.currentSample[g];
+    const auto amplitude = grains.amplitude[g];
+    const auto pitchRatio = grains.pitchRatio[g];
+    const auto readPosition = grains.readPosition[g];
+
+    // look up the window based on grain position within its length
+    const float phaseIncrement = 1.0f / static_cast<float>(grains.totalSamples[g]);
+    windowTables.fillEnvelope(static_cast<GrainWindowTables::WindowType>(granularParams.windowType),
+        static_cast<float>(currentSample) * phaseIncrement,
+        phaseIncrement,
+        amplitude,
+        envelope,
+        length);
+
+    // work out the read positions once, stepping by the pitch ratio, then
+    // gather each channel with the selected interpolation kernel (the kernels
+    // mask the indices, so no wrapping is needed here)
+    const auto quality = static_cast<Interpolation::Quality>(granularParams.interpolationQuality);
+    Interpolation::computePositions(readPosition, pitchRatio, indices, fractions, length);
+
+    // make sure everything the kernels can reach holds current samples, the
+    // widest kernel reaches numTaps / 2 samples either side of each position
+    const auto endPosition = readPosition + static_cast<float>(length - 1) * pitchRatio;
+    const auto reach = Interpolation::SincTable::numTaps / 2;
+    const auto firstIndex = static_cast<int>(std::floor(juce::jmin(readPosition, endPosition))) - reach;
+    const auto lastIndex = static_cast<int>(std::ceil(juce::jmax(readPosition, endPosition))) + reach;
+    delayBuffer.touch(firstIndex, lastIndex - firstIndex + 1);
+
+    // then accumulate the windowed grain into the wet buffer, skipping the
+    // channels a scattered grain isn't panned to
+    const auto isScattered = ringSize > 1 && granularParams.scatter > 0.0f;
+    for (int channel = 0; channel < channelCount; ++channel)
+    {
+        const auto gain = isScattered ? getScatterGain(grain, channel) : 1.0f;
+        if (gain <= 0.0f)
+            continue;
 
-        // get sample from delay buffer with pitch shifting
-        float sample = getDelayedSample(channel, grain.readPosition);
+        kernels->gather(quality, delayBuffer.getReadPointer(channel), delayBuffer.getMask(),
+            indices, fractions, gathered, length, sincTable);
 
-        // apply amplitude and envelope
-        output += sample * grain.grainAmplitude * envelope;
+        if (gain < 1.0f)
+            juce::FloatVectorOperations::multiply(gathered, gain, length);
 
-        // advance grain
-        grain.readPosition += grain.pitchRatio;
-        grain.currentSample++;
+        kernels->addWithMultiply(wetBuffer.getWritePointer(channel, start), gathered, envelope, length);
+    }
 
-        // wrap read position around the delay buffer
-        while (grain.readPosition >= bufferSize)
-            grain.readPosition -= bufferSize;
-        while (grain.readPosition < 0)
-            grain.readPosition += bufferSize;
+    // advance grain and wrap read position around the delay buffer
+    grains.readPosition[g] = delayBuffer.wrapPosition(readPosition + static_cast<float>(length) * pitchRatio);
+    grains.currentSample[g] = currentSample + length;
 
-        // deactivate finished grains
-        if (grain.currentSample >= grain.totalSamples)
-        {
-            grain.active = false;
-        }
+    // report whether the grain is still playing
+    return grains.currentSample[g] < grains.totalSamples[g];
+}
+
+float GranularProcessor::getScatterGain(int grain, int channel) const
+{
+    // the grain sits between two neighbouring channels of the ring, equal
+    // power panned between them
+    const auto place = grains.position[static_cast<size_t>(grain)] * static_cast<float>(ringSize);
+    const auto lower = juce::jmin(static_cast<int>(place), ringSize - 1);
+    const auto upper = (lower + 1) % ringSize;
+    const auto angle = (place - static_cast<float>(lower)) * juce::MathConstants<float>::halfPi;
+
+    // channels outside the ring (an LFE) only get the unscattered part
+    const auto ringPlace = static_cast<size_t>(channel) < ringPlaces.size() ? ringPlaces[static_cast<size_t>(channel)] : -1;
+
+    auto pan = 0.0f;
+    if (ringPlace == lower)
+        pan = std::cos(angle);
+    else if (ringPlace == upper)
+        pan = std::sin(angle);
+
+    // crossfade from every channel to just the panned pair
+    const auto scatter = granularParams.scatter;
+    return (1.0f - scatter) + scatter * pan;
+}
+
+juce::int64 GranularProcessor::getTailSamples(float level) const noexcept
+{
+    // the delay buffer input is a one-pole loop, so it holds at most
+    // level / (1 - feedback) and decays by the feedback every sample. Every
+    // grain in the pool can be reading the same samples at its amplitude
+    const auto feedback = juce::jlimit(0.0f, 0.95f, juce::jmax(feedbackSmoother.getCurrentValue(), feedbackSmoother.getTargetValue()));
+    const auto bufferLevel = level / (1.0f - feedback) * 0.5f * static_cast<float>(grains.getCapacity());
+
+    if (bufferLevel < SilenceDetector::silenceLevel)
+        return 0;
+
+    const auto decay = SilenceDetector::getDecaySamples(bufferLevel, feedback, 1.0);
+
+    // grains start reading at a fixed place in the buffer (the delay time as
+    // an index, not a distance behind the write position), so whatever was
+    // written stays in their reach until the write position comes round and
+    // overwrites it
+    const auto grainSamples = static_cast<double>(granularParams.grainSize) * sampleRate;
+    const auto reach = static_cast<double>(delayBuffer.getCapacity());
+
+    // and grains already playing finish what they read
+    auto playing = grainSamples;
+    for (int slot = 0; slot < grains.getNumActive(); ++slot)
+    {
+        const auto g = static_cast<size_t>(grains.getActiveGrain(slot));
+        playing = juce::jmax(playing, static_cast<double>(grains.totalSamples[g] - grains.currentSample[g]));
     }
 
-    return output;
+    return decay + static_cast<juce::int64>(std::ceil(reach + playing));
+}
+
+double GranularProcessor::getTailLengthSeconds() const noexcept
+{
+    return SilenceDetector::toSeconds(getTailSamples(1.0f), sampleRate);
+}
+
+void GranularProcessor::updateParameters(const GranularParams& params)
+{
+    granularParams = params;
+    // ensure grainDensity is always positive and reasonable
+    granularParams.grainDensity = juce::jlimit(0.01f, 100.0f, granularParams.grainDensity);
+    granularParams.grainSize = juce::jlimit(0.001f, 2.0f, granularParams.grainSize);
+    granularParams.windowType = juce::jlimit(0, GrainWindowTables::numWindowTypes - 1, granularParams.windowType);
+    granularParams.interpolationQuality = juce::jlimit(0, Interpolation::numQualities - 1, granularParams.interpolationQuality);
+    granularParams.scatter = juce::jlimit(0.0f, 1.0f, granularParams.scatter);
+
+    // ramp the per-sample parameters towards their new values
+    feedbackSmoother.setTargetValue(juce::jlimit(0.0f, 0.95f, granularParams.feedback));
+    wetDrySmoother.setTargetValue(granularParams.wetDryMix);
+    updateGrainTiming();
 }
 
-float GranularProcessor::getDelayedSample(int channel, float position)
+void GranularProcessor::triggerNewGrain(int startOffset)
 {
-    // ensure position is within bounds
-    while (position < 0)
-        position += bufferSize;
-    while (position >= bufferSize)
-        position -= bufferSize;
+    // take a free grain from the pool (O(1), -1 if the pool is full)
+    const int grain = grains.spawn();
+    if (grain < 0)
+        return;
 
-    // linear interpolation for fractional delay positions
-    int pos1 = static_cast<int>(std::floor(position)) % bufferSize;
-    int pos2 = (pos1 + 1) % bufferSize;
-    float frac = position - std::floor(position);
+    resetGrain(grain);
+    grains.startOffset[static_cast<size_t>(grain)] = startOffset;
+}
 
-    float sample1 = delayBuffer.getSample(channel, pos1);
-    float sample2 = delayBuffer.getSample(channel, pos2);
+void GranularProcessor::setChannelLayout(const juce::AudioChannelSet& newLayout)
+{
+    channelLayout = newLayout;
+}
 
-    return sample1 * (1.0f - frac) + sample2 * frac;
+void GranularProcessor::setMaxGrains(int newMaxGrains)
+{
+    maxGrains = juce::jmax(1, newMaxGrains);
 }
 
-float GranularProcessor::applyWindow(float phase)
+void GranularProcessor::updateGrainTiming()
 {
-    // hanning window
-    phase = juce::jlimit(0.0f, 1.0f, phase);
-    return 0.5f * (1.0f - std::cos(2.0f * juce::MathConstants<float>::pi * phase));
+    samplesPerGrainTrigger = static_cast<float>(sampleRate / granularParams.grainDensity);
 }
 
 int GranularProcessor::samplesToDelayPosition(float delaySamples)
 {
-    int delayPos = writePos - static_cast<int>(delaySamples);
-    while (delayPos < 0)
-        delayPos += bufferSize;
-    return delayPos % bufferSize;
+    return delayBuffer.wrap(delayBuffer.getWritePosition() - static_cast<int>(delaySamples));
 }
 
-void GranularProcessor::resetGrain(Grain& grain)
+void GranularProcessor::resetGrain(int grain)
 {
-    grain.active = true;
-    grain.totalSamples = static_cast<int>(granularParams.grainSize * sampleRate);
-    grain.currentSample = 0;
-    grain.pitchRatio = granularParams.pitchShift;
-    grain.grainAmplitude = 0.5f;
+    const auto g = static_cast<size_t>(grain);
+    grains.totalSamples[g] = static_cast<int>(granularParams.grainSize * sampleRate);
+    grains.currentSample[g] = 0;
+    grains.pitchRatio[g] = granularParams.pitchShift;
+    grains.amplitude[g] = 0.5f;
     float baseDelayTime = granularParams.delayTime;
     float spreadAmount = granularParams.spread * granularParams.delayTime * spreadDist(rng);
     float grainDelayTime = baseDelayTime + spreadAmount;
     grainDelayTime = juce::jmax(0.01f, grainDelayTime);
-    grain.delayPosition = static_cast<float>(grainDelayTime * sampleRate);
-    grain.readPosition = grain.delayPosition;
+    grains.readPosition[g] = static_cast<float>(grainDelayTime * sampleRate);
+
+    // only draw a place when scattering, so unscattered grains keep the same
+    // random sequence
+    grains.position[g] = granularParams.scatter > 0.0f ? positionDist(rng) : 0.0f;
 }
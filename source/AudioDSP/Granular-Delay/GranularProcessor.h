@@ -17,6 +17,16 @@
  * feedback: Feedback level (0.0 - 1.0)
  * wetDryMix: Wet/dry mix ratio (0.0 - 1.0)
  * spread: Random position spread for grains (0.0 - 1.0)
+ * windowType: Grain envelope shape (0: Hann, 1: Tukey, 2: Gaussian, 3: Trapezoid, 4: Blackman-Harris)
+ * interpolationQuality: Grain playback interpolation (0: Linear, 1: Hermite, 2: Lagrange, 3: Sinc)
+ * scatter: How far each grain is panned to its own place around the output channels (0.0 - 1.0)
+ *
+ * Every output channel gets its own delay line. With scatter at 0 each grain
+ * plays on every channel, at 1 it's panned (equal power) between two
+ * neighbouring channels, treating the layout as a ring (stereo is L/R, a
+ * surround layout goes around the speakers in its channel order, leaving out
+ * the LFE). Ambisonic channels are sound field components rather than
+ * speakers, so grains aren't scattered in those layouts.
  */
 
 #pragma once
@@ -27,6 +37,13 @@
 #include <juce_dsp/juce_dsp.h>
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <random>
+#include "GrainPool.h"
+#include "GrainWindowTables.h"
+#include "../DSPHelpers/RingBuffer/RingBuffer.h"
+#include "../DSPHelpers/Interpolation/Interpolation.h"
+#include "../DSPHelpers/KernelDispatch/KernelDispatch.h"
+#include "../DSPHelpers/ParameterSmoother/ParameterSmoother.h"
+#include "../DSPHelpers/SilenceDetector/SilenceDetector.h"
 
 class GranularProcessor : public juce::dsp::ProcessorBase
 {
@@ -39,6 +56,9 @@ public:
         float feedback = 0.5f;
         float wetDryMix = 0.5f;
         float spread = 0.0f;
+        int windowType = GrainWindowTables::Hann;
+        int interpolationQuality = Interpolation::Linear;
+        float scatter = 0.0f;
     };
 
     GranularProcessor();
@@ -47,64 +67,124 @@ public:
     void prepare(const juce::dsp::ProcessSpec& spec) override;
     void reset() override;
 
+    // free the delay buffer and scratch space until the next prepare (not
+    // from the audio thread)
+    void releaseResources();
+
 
     void process(const juce::dsp::ProcessContextReplacing<float>& context) override;
 
     void updateParameters(const GranularParams& params);
 
+    // render only the grains, scaled by the wet/dry mix, for a send stage
+    // that mixes the dry signal itself (audio thread)
+    void setWetOnly(bool shouldBeWetOnly) noexcept { wetOnly = shouldBeWetOnly; }
+
+    // set the layout of the channels prepare will get, which decides where
+    // grains can be scattered to, takes effect on the next prepare()
+    void setChannelLayout(const juce::AudioChannelSet& newLayout);
+
+    // set the grain pool capacity, takes effect on the next prepare()
+    void setMaxGrains(int newMaxGrains);
+    [[nodiscard]] int getMaxGrains() const noexcept { return maxGrains; }
+
+    // how long grains keep finding full scale input in the delay buffer at
+    // the current settings (audio thread)
+    [[nodiscard]] double getTailLengthSeconds() const noexcept;
+
 
 private:
 
-    // grain structure for holding individual grain parameters
-    struct Grain
+    // channel indices for the per-grain render scratch buffer
+    enum ScratchChannel
     {
-        float delayPosition = 0.0f;     // position in the delay buffer
-        float readPosition = 0.0f;      // current read position (for pitch shift)
-        float grainAmplitude = 0.0f;    // amplitude of the grain
-        float pitchRatio = 1.0f;        // pitch ratio for grain playback
-        int currentSample = 0;          // current sample index in the grain
-        int totalSamples = 0;           // total grain length in samples
-        bool active = false;            // whether this grain is currently active
+        envelopeScratch = 0,
+        fractionScratch,
+        gatherScratch,
+        numScratchChannels
     };
 
     // store the current parameters in a struct
     GranularParams granularParams = {0.5f, 0.5f,
         0.5f, 0.5f, 0.5f, 0.5f,
-        0.5f};
+        0.5f, GrainWindowTables::Hann, Interpolation::Linear};
 
     // store the sample rate, which is set during prepare
     double sampleRate = 44100.0;
 
+    // largest block we've allocated scratch space for in prepare
+    int maxBlockSize = 0;
+
+    bool wetOnly = false;
+
+    // the channel layout from setChannelLayout, and each prepared channel's
+    // place in the scatter ring (-1 for an LFE, which grains aren't panned
+    // to). The ring is empty for ambisonics
+    juce::AudioChannelSet channelLayout;
+    std::vector<int> ringPlaces;
+    int ringSize = 0;
+
     // calculate the maximum number of samples for the delay buffer
     int maxDelaySamples = static_cast<int>(sampleRate * 5.0); // 5 seconds max delay
 
-    // create delay buffer
-    juce::AudioBuffer<float> delayBuffer;
-    int bufferSize = 0;
+    // create delay buffer (power-of-two ring, tracks its own write position)
+    RingBuffer<float> delayBuffer;
 
-    // store the current write position in the delay buffer
-    int writePos = 0;
+    // block-sized scratch buffers for the grain renderer, allocated in prepare
+    juce::AudioBuffer<float> wetBuffer;     // accumulated grain output per channel
+    juce::AudioBuffer<float> grainScratch;  // envelope, fractions + interpolated reads for one grain
+    std::vector<int> grainIndices;          // integer read indices for one grain
 
-    // juce::Array to hold grains instead of std::vector
-    juce::Array<Grain> grains;
+    // structure-of-arrays grain pool, allocated in prepare
+    GrainPool grains;
     int maxGrains = 256; // maximum number of grains in the pool
     float grainTriggerTimer = 0.0f;      // timer for triggering new grains
     float samplesPerGrainTrigger = 0.0f; // samples per grain trigger based on density
 
+    // per-sample ramps for the parameters applied every sample
+    ParameterSmoother feedbackSmoother;
+    ParameterSmoother wetDrySmoother;
+    static constexpr double gainRampSeconds = 0.02;
+
+    // precomputed grain envelopes, built in prepare
+    GrainWindowTables windowTables;
+
+    // polyphase table for the sinc interpolation quality, built in prepare
+    Interpolation::SincTable sincTable;
+
+    // skips blocks once the input and everything the grains can reach are silent
+    SilenceDetector silenceDetector;
+
+    // gather, grain accumulation and mix loops for this CPU, picked in prepare
+    const KernelDispatch::Kernels* kernels = &KernelDispatch::getKernels(KernelDispatch::Generic);
+
     // random number generator for spread + pitch shift + grain density
     std::mt19937 rng;
 
     // distributions for generating random values
     std::uniform_real_distribution<float> spreadDist {-1.0f, 1.0f};
-
-    // helper methods
-    void triggerNewGrain();
+    std::uniform_real_distribution<float> positionDist {0.0f, 1.0f};
+
+    // template argument for the kernels that take the channel count from the block
+    static constexpr int anyChannels = 0;
+
+    // helper methods (the per-sample ones are instantiated for mono, stereo
+    // and any other channel count)
+    template <int numChannels>
+    void processChunk(const juce::dsp::AudioBlock<float>& block);
+    template <int numChannels>
+    void writeToDelayBuffer(const juce::dsp::AudioBlock<float>& block, const float* feedbacks);
+    void scheduleGrains(int numSamples);
+    template <int numChannels>
+    void renderGrains(int numSamples, int channelCount);
+    template <int numChannels>
+    bool renderGrain(int grain, int numSamples, int channelCount);
+    float getScatterGain(int grain, int channel) const;
+    void triggerNewGrain(int startOffset);
     void updateGrainTiming();
-    float processActiveGrains(int channel);
-    float getDelayedSample(int channel, float position);
-    float applyWindow(float phase); // hanning window function for grains (TODO: implement more window types)
     int samplesToDelayPosition(float delaySamples);
-    void resetGrain(Grain& grain);
+    void resetGrain(int grain);
+    [[nodiscard]] juce::int64 getTailSamples(float level) const noexcept;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GranularProcessor)
 };
@@ -21,157 +21,173 @@ void LooperProcessor::prepare (const juce::dsp::ProcessSpec& spec)
     // calculate buffer size for maximum buffer length in samples
     maxBufferSize = static_cast<int>(60 * sampleRate); // 60 seconds of looper memory
 
-    // prepare AudioBuffer for loop
-    loopBuffer.setSize(2, maxBufferSize);
+    // size the loop memory, one track per channel, only the chunk table is
+    // allocated here, the audio memory is committed as recording reaches it
+    loopStore.prepare(static_cast<int>(spec.numChannels), maxBufferSize, ChunkedAudioStore::defaultChunkSize,
+                      ChunkedAudioStore::getReserveChunks(sampleRate, static_cast<int>(spec.maximumBlockSize)));
     reset();
 }
 
 void LooperProcessor::reset()
 {
-    loopBuffer.clear();
+    loopStore.releaseAll();
     position = 0;
     loopLength = 0;
     currentState = Stopped;
 }
 
-void LooperProcessor::setState(State newState)
+void LooperProcessor::releaseResources()
+{
+    // the loop is lost along with its memory
+    loopStore.release();
+    position = 0;
+    loopLength = 0;
+    currentState = Stopped;
+
+    // process() refuses to run until we're prepared again
+    maxBufferSize = 0;
+}
+
+void LooperProcessor::process (const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    if (!context.isBypassed)
+    {
+        // the loop buffer is sized in prepare, so we can't run before that
+        jassert(maxBufferSize > 0);
+        if (maxBufferSize <= 0)
+            return;
+
+        // input and output are the same block, so pass-through is a no-op and
+        // the kernels only have to touch the samples they change
+        auto& outputBlock = context.getOutputBlock();
+        const auto numSamples = static_cast<int>(outputBlock.getNumSamples());
+
+        for (int start = 0; start < numSamples;)
+            start += processSegment(outputBlock, start, numSamples - start);
+    }
+}
+
+double LooperProcessor::getTailLengthSeconds() const noexcept
+{
+    const auto isLooping = (currentState == Playing || currentState == Overdubbing) && loopLength > 0;
+    return isLooping ? SilenceDetector::longestTailSeconds : 0.0;
+}
+
+int LooperProcessor::processSegment(const juce::dsp::AudioBlock<float>& block, int start, int num)
 {
-    // DBG("setState: " << currentState << " -> " << newState);
-    currentState = newState;
     switch (currentState)
     {
         case Recording:
-            processSample = [this](float inL, float inR, float& outL, float& outR)
-            {
-                handleRecording(inL, inR, outL, outR);
-            };
-            break;
+            return recordSegment(block, start, num);
         case Playing:
-            processSample = [this](float, float, float& outL, float& outR)
-            {
-                handlePlaying(outL, outR);
-            };
-            break;
+            return playSegment(block, start, num);
         case Overdubbing:
-            processSample = [this](float inL, float inR, float& outL, float& outR)
-            {
-                handleOverdubbing(inL, inR, outL, outR);
-            };
-            break;
+            return overdubSegment(block, start, num);
         case Stopped:
-            processSample = [this](float inL, float inR, float& outL, float& outR) {
-                outL = inL;
-                outR = inR;
-            };
-            break;
         case Clear:
-            processSample = [this](float, float, float&, float&)
-            {
-                clear();
-                currentState = Stopped;
-            };
-            break;
         default:
-            processSample = [this](float inL, float inR, float& outL, float& outR)
-            {
-                outL = inL;
-                outR = inR;
-                // default to stopped state processing so that the chain doesn't break
-            };
-            break;
+            // stopped passes the input through untouched
+            return num;
     }
 }
 
-void LooperProcessor::process (const juce::dsp::ProcessContextReplacing<float>& context)
+// block kernels for each state
+int LooperProcessor::recordSegment(const juce::dsp::AudioBlock<float>& block, int start, int num)
 {
-    if (context.getOutputBlock().getNumChannels() != 0)
+    // record up to the end of the looper memory
+    const int count = juce::jmin(num, maxBufferSize - position);
+    loopStore.ensureMapped(position, count);
+
+    // a block narrower than the loop (mono input) is recorded into every
+    // loop channel from its last one
+    const auto numChannels = block.getNumChannels();
+    for (int channel = 0; channel < loopStore.getNumChannels(); ++channel)
     {
-        DBG("Signal has hit the LooperProcessor!");
+        const auto* input = block.getChannelPointer(juce::jmin(static_cast<size_t>(channel), numChannels - 1));
+        loopStore.copyIn(channel, position, input + start, count);
     }
-    if (!context.isBypassed)
-    {
-        DBG("Signal was not bypassed at the LooperProcessor");
-        auto& inputBlock = context.getInputBlock();
-        auto& outputBlock = context.getOutputBlock();
-        const auto numChannels = juce::jmin(
-            inputBlock.getNumChannels(),
-            outputBlock.getNumChannels(),
-            static_cast<size_t> (2)
-        );
-        const auto numSamples = inputBlock.getNumSamples();
-
-        for (int sample = 0; sample < numSamples; ++sample)
-        {
-            float inputL = inputBlock.getSample(0, sample);
-            float inputR = (numChannels > 1) ? inputBlock.getSample(1, sample) : inputL;
-            float outL = 0.0f, outR = 0.0f;
-
-            if (processSample)
-                processSample(inputL, inputR, outL, outR);
-
-            outputBlock.setSample(0, sample, outL);
-            if (numChannels > 1)
-                outputBlock.setSample(1, sample, outR);
-            else
-                outputBlock.setSample(1, sample, outL); // mono case
-        }
-    } else DBG("Signal was bypassed at the LooperProcessor");
-}
-
-// Helper methods for each state
-void LooperProcessor::handleRecording(float inputL, float inputR, float& outL, float& outR)
-{
-    loopBuffer.setSample(0, position, inputL);
-    loopBuffer.setSample(1, position, inputR);
-    position++;
-    // Always update loopLength to the current position while recording
+
+    // the loop is always as long as what's been recorded so far
+    position += count;
     loopLength = position;
-    // DBG("Recording: pos=" << position << ", inL=" << inputL << ", inR=" << inputR << ", loopLength=" << loopLength);
-    outL = inputL;
-    outR = inputR;
+
     if (position >= maxBufferSize)
     {
         // if we hit max buffer, set loopLength and switch to playing
         loopLength = maxBufferSize;
         position = 0;
-        setState(Playing);
+        currentState = Playing;
     }
+
+    // output is the input, which is already in place
+    return count;
 }
 
-void LooperProcessor::handlePlaying(float& outL, float& outR)
+int LooperProcessor::playSegment(const juce::dsp::AudioBlock<float>& block, int start, int num)
 {
-    outL = loopBuffer.getSample(0, position);
-    outR = loopBuffer.getSample(1, position);
-    position = (position + 1) % juce::jmax(1, loopLength);
+    // play up to the loop point
+    const int count = juce::jmin(num, loopLength - position);
+
+    const auto numChannels = juce::jmin(block.getNumChannels(), static_cast<size_t>(loopStore.getNumChannels()));
+    for (size_t channel = 0; channel < numChannels; ++channel)
+        loopStore.copyOut(static_cast<int>(channel), position, block.getChannelPointer(channel) + start, count);
+
+    position += count;
+    if (position >= loopLength)
+        position = 0;
+
+    return count;
 }
 
-void LooperProcessor::handleOverdubbing(float inputL, float inputR, float& outL, float& outR)
+int LooperProcessor::overdubSegment(const juce::dsp::AudioBlock<float>& block, int start, int num)
 {
     // simple overdub: add input to buffer sample.
     // TODO: implement another buffer to hold the overdub layer, and allow it to
     //       be cleared independently from the main loop buffer
-    float mixL = loopBuffer.getSample(0, position) + inputL;
-    float mixR = loopBuffer.getSample(1, position) + inputR;
-    loopBuffer.setSample(0, position, mixL);
-    loopBuffer.setSample(1, position, mixR);
-    outL = mixL;
-    outR = mixR;
-    position = (position + 1) % juce::jmax(1, loopLength);
+    const int count = juce::jmin(num, loopLength - position);
+
+    const auto numChannels = block.getNumChannels();
+    // every chunk of the loop was mapped while recording, unless the pool ran
+    // dry then, in which case this is where it catches up
+    loopStore.ensureMapped(position, count);
+
+    for (int channel = 0; channel < loopStore.getNumChannels(); ++channel)
+    {
+        const auto* input = block.getChannelPointer(juce::jmin(static_cast<size_t>(channel), numChannels - 1));
+        loopStore.addIn(channel, position, input + start, count);
+    }
+
+    // the output is the mixed loop
+    for (size_t channel = 0; channel < juce::jmin(numChannels, static_cast<size_t>(loopStore.getNumChannels())); ++channel)
+        loopStore.copyOut(static_cast<int>(channel), position, block.getChannelPointer(channel) + start, count);
+
+    position += count;
+    if (position >= loopLength)
+        position = 0;
+
+    return count;
 }
 
 // state management methods
 void LooperProcessor::startRecording()
 {
-    setState(Recording);
+    // a new take always starts from the top, and the old take's memory goes
+    // back to the pool
+    loopStore.releaseAll();
+    currentState = Recording;
     position = 0;
+    loopLength = 0;
 }
 
 void LooperProcessor::startPlayback()
 {
     if (loopLength > 0)
     {
-        position = 0;
-        setState(Playing);
+        // continue from where overdubbing left off, or from the top after
+        // recording or stopping
+        if (position >= loopLength)
+            position = 0;
+        currentState = Playing;
     }
 }
 
@@ -179,27 +195,26 @@ void LooperProcessor::startOverdubbing()
 {
     if (loopLength > 0)
     {
-        setState(Overdubbing);
+        if (position >= loopLength)
+            position = 0;
+        currentState = Overdubbing;
     }
 }
 
 void LooperProcessor::stop()
 {
-    // if (currentState == Recording)
-    // {
-    //     loopLength = position; // Always set loopLength to number of recorded samples
-    // }
-    //
     position = 0;
-    setState(Stopped);
+    currentState = Stopped;
 }
 
 void LooperProcessor::clear()
 {
-    loopBuffer.clear();
+    // hand the loop's chunks back to the pool, the service thread zeroes and
+    // frees them instead of this callback
+    loopStore.releaseAll();
     position = 0;
     loopLength = 0;
-    setState(Stopped);
+    currentState = Stopped;
 }
 
 float LooperProcessor::getLoopPosition() const noexcept
@@ -209,11 +224,16 @@ float LooperProcessor::getLoopPosition() const noexcept
     return static_cast<float>(position) / static_cast<float>(loopLength);
 }
 
-void LooperProcessor::updateParameters(const LooperParams& params)
+void LooperProcessor::setState(int newState)
 {
-    if (static_cast<int>(currentState) != params.looperState)
+    // Clear is a one-shot command that leaves the looper stopped
+    switch (newState)
     {
-        setState(static_cast<State>(params.looperState));
+        case Recording:   startRecording();   break;
+        case Playing:     startPlayback();    break;
+        case Overdubbing: startOverdubbing(); break;
+        case Stopped:     stop();             break;
+        case Clear:       clear();            break;
+        default:          jassertfalse;       break;
     }
-    previousParams = params;
 }
@@ -19,25 +19,21 @@
 
 #include <juce_dsp/juce_dsp.h>
 #include <juce_audio_processors/juce_audio_processors.h>
-#include <functional>
+#include "../DSPHelpers/ChunkedAudioStore/ChunkedAudioStore.h"
+#include "../DSPHelpers/SilenceDetector/SilenceDetector.h"
 
 class LooperProcessor : public juce::dsp::ProcessorBase
 {
 public:
-    struct LooperParams {
-        // parameter for the looper, default to stopped (3, from the State enum)
-        mutable int looperState = 3;
-    };
-
     LooperProcessor();
     ~LooperProcessor() override;
 
     void prepare(const juce::dsp::ProcessSpec& spec) override;
     void reset() override;
     void process (const juce::dsp::ProcessContextReplacing<float>& context) override;
-    void handleRecording (float inputL, float inputR, float& outL, float& outR);
-    void handlePlaying (float& outL, float& outR);
-    void handleOverdubbing (float inputL, float inputR, float& outL, float& outR);
+
+    // free the loop memory until the next prepare (not from the audio thread)
+    void releaseResources();
 
     // Looper state management
     void startRecording();
@@ -58,24 +54,47 @@ public:
 
     // parameter getters
     State getState() const noexcept { return currentState; }
+
+    // whether there's a recording in the loop store, which releasing the
+    // looper's resources would throw away
+    [[nodiscard]] bool hasLoop() const noexcept { return loopLength > 0 || currentState == Recording; }
     float getLoopPosition() const noexcept;
 
-    void updateParameters(const LooperParams& params);
+    // a loop keeps playing without any input, so while there's one playing
+    // (or being overdubbed) the tail never ends, and we report the longest
+    // one (SilenceDetector::longestTailSeconds). Stopped and
+    // recording pass the input through, with no tail. A stopped looper
+    // already leaves the block untouched, so there's nothing to skip on
+    // silence either
+    [[nodiscard]] double getTailLengthSeconds() const noexcept;
+
+    // recorded samples lost since prepare because the loop memory couldn't
+    // be committed in time (any thread)
+    [[nodiscard]] juce::int64 getNumDroppedSamples() const noexcept { return loopStore.getNumDroppedSamples(); }
+
+    // apply a transport command from the looperState parameter. Every call
+    // is a new button press, so repeating a command (e.g. Clear) acts again
+    void setState(int newState);
 
 private:
-    juce::AudioBuffer<float> loopBuffer;
+    // loop memory, a track per channel, chunks are committed as recording
+    // reaches them and handed back to the pool on clear, so an empty looper
+    // holds almost nothing
+    ChunkedAudioStore loopStore;
     int loopLength = 0;
     int position = 0;
     State currentState = Stopped;
     double sampleRate = 44100.0f;
     int maxBufferSize = 0;
 
-    // keep track of previous button states to detect changes
-    LooperParams previousParams;
-
-    // function pointer for per-sample processing
-    std::function<void(float, float, float&, float&)> processSample = nullptr;
-    void setState(State newState);
+    //=block kernels============================================================
+    // each kernel handles samples [start, start + num) of the block up to the
+    // next loop boundary and returns how many it consumed, so process() only
+    // switches on the state once per segment instead of once per sample
+    int processSegment(const juce::dsp::AudioBlock<float>& block, int start, int num);
+    int recordSegment(const juce::dsp::AudioBlock<float>& block, int start, int num);
+    int playSegment(const juce::dsp::AudioBlock<float>& block, int start, int num);
+    int overdubSegment(const juce::dsp::AudioBlock<float>& block, int start, int num);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LooperProcessor)
 };
@@ -18,80 +18,212 @@ void ReverbProcessor::prepare(const juce::dsp::ProcessSpec& spec)
 {
     sampleRate = spec.sampleRate;
 
-    // prepare the reverb processor
-    reverb.prepare(spec);
-    reverb.reset();
+    // mono and stereo keep the one reverb (and its width), wider layouts get
+    // a mono reverb per channel
+    const auto numChannels = static_cast<int>(spec.numChannels);
+    isPerChannel = numChannels > 2;
+    const auto numReverbs = isPerChannel ? numChannels : 1;
+
+    while (reverbs.size() < numReverbs)
+        reverbs.add(new juce::dsp::Reverb());
+    reverbs.removeLast(reverbs.size() - numReverbs);
+
+    for (auto* reverb : reverbs)
+    {
+        auto reverbSpec = spec;
+        reverbSpec.numChannels = isPerChannel ? 1u : spec.numChannels;
+
+        reverb->prepare(reverbSpec);
+        reverb->reset();
+    }
+
+    // find the LFEs, if we've been given the layout for these channels
+    lfeChannels = 0;
+    if (isPerChannel && channelLayout.size() == numChannels)
+        for (const auto type : { juce::AudioChannelSet::LFE, juce::AudioChannelSet::LFE2 })
+            if (const auto index = channelLayout.getChannelIndexForType(type); index >= 0)
+                lfeChannels |= 1u << index;
+
+    lfeGain.reset(sampleRate, 0.01);
 
     // prepare low-pass filter for damping enhancement
     lowPassFilter.prepare(spec);
     lowPassFilter.reset();
 
-    // set initial filter coefficients (12khz cutoff)
-    *lowPassFilter.state = *juce::dsp::IIR::Coefficients<float>::makeLowPass(
-        spec.sampleRate, 12000.0f, 0.707f);
+    // set initial filter coefficients from the current tone parameter, the
+    // first assignment sizes the coefficient array so later updates don't
+    // allocate
+    updateToneFilter(currentToneCutoff);
+
+    // apply the current reverb parameters
+    setReverbParameters();
+    lfeGain.setCurrentAndTargetValue(lfeGain.getTargetValue());
 }
 
 void ReverbProcessor::reset()
 {
-    reverb.reset();
+    for (auto* reverb : reverbs)
+        reverb->reset();
+
     lowPassFilter.reset();
+    lfeGain.setCurrentAndTargetValue(lfeGain.getTargetValue());
+    silenceDetector.reset();
+}
+
+void ReverbProcessor::releaseResources()
+{
+    reset();
 }
 
 // required implementation for ProcessorBase inheritance
 void ReverbProcessor::process(const juce::dsp::ProcessContextReplacing<float>& context)
 {
-    if (context.getOutputBlock().getNumChannels() != 0)
-    {
-        DBG("Signal has hit the ReverbProcessor!");
-    }
     if (!context.isBypassed)
     {
-        DBG("Signal was not bypassed at the ReverbProcessor");
         auto& inputBlock = context.getInputBlock();
         auto& outputBlock = context.getOutputBlock();
 
         // make sure we have right number of channels
         jassert (inputBlock.getNumChannels() >= 1);
         jassert (outputBlock.getNumChannels() >= 1);
+        juce::ignoreUnused (inputBlock);
 
-        // // create an AudioBlock to work with
-        // juce::dsp::AudioBlock<float> block (outputBlock);
+        // skip the block while the input and the tail are both silent
+        const auto silence = silenceDetector.process(outputBlock,
+            [this](float level) { return getTailSamples(level); });
 
-        // // copy input to output if they're not already the same
-        // if (context.usesSeparateInputAndOutputBlocks())
-        //     outputBlock.copyFrom (inputBlock);
-
-        // store clean signal for dry/wet mixing
-        juce::HeapBlock<float> cleanSignalL (outputBlock.getNumSamples());
-        juce::HeapBlock<float> cleanSignalR (outputBlock.getNumSamples());
-
-        for (int i = 0; i < outputBlock.getNumSamples(); ++i)
+        if (silence != SilenceDetector::awake)
         {
-            cleanSignalL[i] = outputBlock.getSample (0, i);
-            cleanSignalR[i] = outputBlock.getNumChannels() > 1 ? outputBlock.getSample (1, i) : outputBlock.getSample (0, i);
+            // clear what's left of the tail (below the silence level) so we
+            // wake up from empty
+            if (silence == SilenceDetector::fallingAsleep)
+                reset();
+
+            // the silent input is already the dry signal, and a send renders nothing
+            if (wetOnly)
+                outputBlock.clear();
+            return;
         }
 
-        reverb.setParameters(reverbParams);
-
-        // process through reverb
-        juce::dsp::ProcessContextReplacing<float> reverbContext (outputBlock);
-        reverb.process(reverbContext);
+        // process the channels through their reverbs (parameters are
+        // applied in updateParameters, which only runs when they change)
+        if (isPerChannel)
+            processPerChannel(outputBlock);
+        else if (!reverbs.isEmpty())
+            reverbs.getUnchecked(0)->process(juce::dsp::ProcessContextReplacing<float> (outputBlock));
 
         // apply low-pass filter for damping enhancement
-        *lowPassFilter.state = *juce::dsp::IIR::Coefficients<float>::makeLowPass (
-            sampleRate, 12000.0f, 0.707f);
+        juce::dsp::ProcessContextReplacing<float> reverbContext (outputBlock);
         lowPassFilter.process(reverbContext);
-    } else DBG("Signal was bypassed at the ReverbProcessor");
+    }
 }
 
 void ReverbProcessor::updateParameters(const ReverbParams& params)
 {
+    dryLevel = params.dryLevel;
+
     reverbParams = {
         params.roomSize,
         params.damping,
         params.wetLevel,
-        params.dryLevel,
+        wetOnly ? 0.0f : dryLevel,
         params.width,
         static_cast<float>(params.freezeMode > 0.5f)
     };
+    setReverbParameters();
+
+    // only rebuild the tone filter when the cutoff actually moves
+    if (params.toneCutoff != currentToneCutoff)
+        updateToneFilter(params.toneCutoff);
+}
+
+void ReverbProcessor::setWetOnly(bool shouldBeWetOnly)
+{
+    if (shouldBeWetOnly == wetOnly)
+        return;
+
+    wetOnly = shouldBeWetOnly;
+    reverbParams.dryLevel = wetOnly ? 0.0f : dryLevel;
+    setReverbParameters();
+}
+
+void ReverbProcessor::processPerChannel(const juce::dsp::AudioBlock<float>& block)
+{
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+    const auto numChannels = juce::jmin(block.getNumChannels(), static_cast<size_t>(reverbs.size()));
+
+    // the LFE gain ramp for this block, shared by every LFE channel
+    const auto startGain = lfeGain.getCurrentValue();
+    const auto endGain = lfeChannels != 0 ? lfeGain.skip(numSamples) : startGain;
+    const auto gainStep = (endGain - startGain) / static_cast<float>(numSamples);
+
+    for (size_t channel = 0; channel < numChannels; ++channel)
+    {
+        auto channelBlock = block.getSingleChannelBlock(channel);
+
+        if ((lfeChannels & (1u << channel)) == 0)
+        {
+            reverbs.getUnchecked(static_cast<int>(channel))->process(juce::dsp::ProcessContextReplacing<float> (channelBlock));
+            continue;
+        }
+
+        auto* samples = channelBlock.getChannelPointer(0);
+        for (int i = 0; i < numSamples; ++i)
+            samples[i] *= startGain + gainStep * static_cast<float>(i + 1);
+    }
+}
+
+juce::int64 ReverbProcessor::getTailSamples(float level) const noexcept
+{
+    if (reverbParams.freezeMode >= 0.5f)
+        return SilenceDetector::endlessTail;
+
+    // juce::dsp::Reverb is Freeverb: eight parallel combs with a feedback of
+    // roomSize * 0.28 + 0.7 (damping only takes the highs down faster), the
+    // longest 1617 + 23 samples at 44.1 kHz, into four allpasses. The input
+    // is scaled by 0.015 and the wet output by 3 (up to 1.5 times that with
+    // the width mixing in the other channel), and each comb can resonate up
+    // to 1 / (1 - feedback) times its input
+    const auto scale = sampleRate / 44100.0;
+    const auto feedback = reverbParams.roomSize * 0.28f + 0.7f;
+    const auto wetLevel = level * 8.0f * 0.015f * 3.0f * 1.5f * reverbParams.wetLevel / (1.0f - feedback);
+
+    if (wetLevel < SilenceDetector::silenceLevel)
+        return 0;
+
+    const auto combs = SilenceDetector::getDecaySamples(wetLevel, feedback, (1617 + 23) * scale);
+    const auto allpasses = (556 + 441 + 341 + 225 + 4 * 23) * scale;
+
+    return combs + static_cast<juce::int64>(std::ceil(allpasses));
+}
+
+double ReverbProcessor::getTailLengthSeconds() const noexcept
+{
+    return SilenceDetector::toSeconds(getTailSamples(1.0f), sampleRate);
+}
+
+void ReverbProcessor::setChannelLayout(const juce::AudioChannelSet& newLayout)
+{
+    channelLayout = newLayout;
+}
+
+void ReverbProcessor::setReverbParameters()
+{
+    for (auto* reverb : reverbs)
+        reverb->setParameters(reverbParams);
+
+    lfeGain.setTargetValue(reverbParams.dryLevel * dryScaleFactor);
+}
+
+void ReverbProcessor::updateToneFilter(float cutoff)
+{
+    currentToneCutoff = cutoff;
+
+    // keep the cutoff safely below nyquist for low sample rates
+    const auto safeCutoff = juce::jlimit(20.0f, static_cast<float>(sampleRate * 0.45), cutoff);
+
+    // assigning an array writes into the existing coefficients object instead
+    // of allocating a new one like Coefficients::makeLowPass does
+    *lowPassFilter.state = juce::dsp::IIR::ArrayCoefficients<float>::makeLowPass(
+        sampleRate, safeCutoff, 0.707f);
 }
\ No newline at end of file
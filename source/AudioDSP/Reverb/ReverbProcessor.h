@@ -7,6 +7,11 @@
  * @brief Reverb processor with adjustable parameters
  *
  * Implements a standard reverb effect, with parameters for room size, damping, wet/dry mix, stereo width, and freeze mode.
+ * Layouts wider than stereo run a mono reverb per channel, since pairing them
+ * would cross-feed channels that don't belong together (C into LFE in 5.1,
+ * ambisonic components into each other). That leaves those layouts without
+ * the width control, and an ambisonic reverb that's per component rather than
+ * a spatial one. LFE channels skip the reverb and only get its dry level.
  *
  * @description
  * roomSize: Size of the reverb room (0.0 - 1.0)
@@ -15,12 +20,14 @@
  * dryLevel: Dry level of the reverb (0.0 - 1.0)
  * width: Stereo width of the reverb (0.0 - 1.0)
  * freezeMode: Freeze mode (0.0 - 1.0, implemented as a toggle button in the UI
+ * toneCutoff: Cutoff of the low-pass tone filter after the reverb in Hz (1000 - 20000)
  */
 
 #pragma once
 
 #include <juce_dsp/juce_dsp.h>
 #include <juce_audio_processors/juce_audio_processors.h>
+#include "../DSPHelpers/SilenceDetector/SilenceDetector.h"
 
 #ifndef REVERBPROCESSOR_H
 #define REVERBPROCESSOR_H
@@ -34,6 +41,7 @@ public:
         float dryLevel = 0.4f;
         float width = 1.0f;
         float freezeMode = 0.0f;
+        float toneCutoff = 12000.0f;
     };
 
     ReverbProcessor();
@@ -42,19 +50,70 @@ public:
     void prepare(const juce::dsp::ProcessSpec& spec) override;
     void reset() override;
 
+    // counterpart of the other processors' releaseResources, juce::dsp::Reverb
+    // keeps its (small) comb filters until it's destroyed, so this only
+    // clears the tails
+    void releaseResources();
+
     // required implementation of ProcessorBase::process
     void process(const juce::dsp::ProcessContextReplacing<float>& context) override;
 
     void updateParameters(const ReverbParams& params);
+
+    // set the layout of the channels prepare will get, which tells it where
+    // the LFE is, takes effect on the next prepare()
+    void setChannelLayout(const juce::AudioChannelSet& newLayout);
+
+    // mute the reverb's own dry signal for a send stage that mixes it in
+    // itself (audio thread)
+    void setWetOnly(bool shouldBeWetOnly);
+
+    // how long the reverb of full scale input takes to die away at the
+    // current room size, the longest tail we report while frozen (audio
+    // thread)
+    [[nodiscard]] double getTailLengthSeconds() const noexcept;
 private:
-    juce::dsp::Reverb reverb;
+    // one for mono or stereo, otherwise one mono reverb per channel,
+    // allocated in prepare
+    juce::OwnedArray<juce::dsp::Reverb> reverbs;
+    bool isPerChannel = false;
+
+    // the layout from setChannelLayout, and a bit per prepared channel that's
+    // an LFE, which gets the dry gain (ramped like juce's) instead of a reverb
+    juce::AudioChannelSet channelLayout;
+    juce::uint32 lfeChannels = 0;
+    juce::SmoothedValue<float> lfeGain;
+
+    // juce::Reverb scales its dry level by this
+    static constexpr float dryScaleFactor = 2.0f;
     juce::dsp::Reverb::Parameters reverbParams;
 
-    // additional processing for stereo width
+    void setReverbParameters();
+
+    // low-pass tone filter for damping enhancement
     juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>,
                 juce::dsp::IIR::Coefficients<float>> lowPassFilter;
 
-    double sampleRate;
+    double sampleRate = 44100.0;
+
+    // dry level from the parameters, applied unless we're wet only
+    float dryLevel = 0.4f;
+    bool wetOnly = false;
+
+    // tone cutoff the filter coefficients were last computed for
+    float currentToneCutoff = 12000.0f;
+
+    // skips blocks once the input and the reverb tail are both silent
+    SilenceDetector silenceDetector;
+
+    // samples the reverb of input peaking at level rings for
+    [[nodiscard]] juce::int64 getTailSamples(float level) const noexcept;
+
+    // run each channel through its own reverb, and the LFEs past them
+    void processPerChannel(const juce::dsp::AudioBlock<float>& block);
+
+    // recompute the tone filter coefficients in place (no allocation)
+    void updateToneFilter(float cutoff);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ReverbProcessor)
 };
@@ -0,0 +1,244 @@
+#include "ExecutionPlan.h"
+#include "../DSPHelpers/SignalGuard/SignalGuard.h"
+
+//=ProcessingGraph==============================================================
+
+ProcessingGraph& ProcessingGraph::then(std::initializer_list<int> processors)
+{
+    stages.push_back({ Branch { processors, 1.0f } });
+    return *this;
+}
+
+ProcessingGraph& ProcessingGraph::split(std::initializer_list<Branch> branches)
+{
+    stages.emplace_back(branches);
+    return *this;
+}
+
+ProcessingGraph& ProcessingGraph::sends(std::initializer_list<Branch> returns, float dryLevel)
+{
+    // the dry path goes first so it stays on the main block, and the returns
+    // are rendered from copies of the stage input
+    Stage stage { Branch { {}, dryLevel } };
+
+    for (auto branch : returns)
+    {
+        branch.wetOnly = true;
+        stage.push_back(std::move(branch));
+    }
+
+    stages.push_back(std::move(stage));
+    return *this;
+}
+
+uint32_t ProcessingGraph::getProcessorMask() const noexcept
+{
+    uint32_t mask = 0;
+    for (const auto& stage : stages)
+        for (const auto& branch : stage)
+            for (const auto processor : branch.processors)
+                mask |= 1u << processor;
+    return mask;
+}
+
+uint32_t ProcessingGraph::getWetOnlyMask() const noexcept
+{
+    uint32_t mask = 0;
+    for (const auto& stage : stages)
+        for (const auto& branch : stage)
+            if (branch.wetOnly)
+                for (const auto processor : branch.processors)
+                    mask |= 1u << processor;
+    return mask;
+}
+
+bool ProcessingGraph::isValid() const noexcept
+{
+    uint32_t mask = 0;
+    for (const auto& stage : stages)
+    {
+        for (const auto& branch : stage)
+        {
+            for (const auto processor : branch.processors)
+            {
+                if (processor < 0 || processor >= 32 || (mask & (1u << processor)) != 0)
+                    return false;
+                mask |= 1u << processor;
+            }
+        }
+    }
+    return true;
+}
+
+//=ExecutionPlan================================================================
+
+ExecutionPlan::ExecutionPlan(const ProcessingGraph& graphToCompile, const juce::dsp::ProcessSpec& spec,
+                             uint32_t keepStateProcessors)
+    : graph(graphToCompile), keepStateMask(keepStateProcessors),
+      kernels(&KernelDispatch::getKernels(KernelDispatch::selectIsa()))
+{
+    jassert(graph.isValid());
+    wetOnlyMask = graph.getWetOnlyMask();
+
+    int numScratch = 0;
+
+    for (const auto& stage : graph.stages)
+    {
+        if (stage.empty())
+            continue;
+
+        const auto numBranches = static_cast<int>(stage.size());
+        numScratch = juce::jmax(numScratch, numBranches - 1);
+
+        // a serial stage just runs its processors on the main block
+        if (numBranches == 1)
+        {
+            for (const auto processor : stage.front().processors)
+            {
+                steps.push_back({ processMain, processor, -1, 1.0f });
+                processorMask |= 1u << processor;
+            }
+
+            if (stage.front().mix != 1.0f)
+                steps.push_back({ scaleMain, -1, -1, stage.front().mix });
+
+            continue;
+        }
+
+        // every branch after the first starts from a copy of the stage input,
+        // so take the copies before the first branch changes the main block
+        for (int branch = 1; branch < numBranches; ++branch)
+            steps.push_back({ copyToScratch, -1, branch - 1, 1.0f });
+
+        // then one job per branch with processors to run, the branches only
+        // touch their own block, so the jobs can run in any order
+        Step run { runBranches };
+        run.first = static_cast<int>(branchJobs.size());
+
+        for (int branch = 0; branch < numBranches; ++branch)
+        {
+            const auto& processors = stage[static_cast<size_t>(branch)].processors;
+            if (processors.empty())
+                continue;
+
+            branchJobs.push_back({ static_cast<int>(branchSteps.size()), static_cast<int>(processors.size()) });
+
+            for (const auto processor : processors)
+            {
+                branchSteps.push_back({ branch == 0 ? processMain : processScratch, processor, branch - 1, 1.0f });
+                processorMask |= 1u << processor;
+            }
+        }
+
+        run.count = static_cast<int>(branchJobs.size()) - run.first;
+        if (run.count > 0)
+            steps.push_back(run);
+
+        // and finally sum the branches into the main block
+        if (stage.front().mix != 1.0f)
+            steps.push_back({ scaleMain, -1, -1, stage.front().mix });
+
+        for (int branch = 1; branch < numBranches; ++branch)
+            steps.push_back({ addScratch, -1, branch - 1, stage[static_cast<size_t>(branch)].mix });
+    }
+
+    numScratchChannels = static_cast<int>(spec.numChannels);
+    scratchBuffers.setSize(numScratch * numScratchChannels, static_cast<int>(spec.maximumBlockSize));
+    scratchChannels = scratchBuffers.getArrayOfWritePointers();
+}
+
+juce::dsp::AudioBlock<float> ExecutionPlan::getScratchBlock(int scratch, size_t numChannels, size_t numSamples) noexcept
+{
+    return juce::dsp::AudioBlock<float>(scratchChannels + scratch * numScratchChannels,
+                                        numChannels, numSamples);
+}
+
+void ExecutionPlan::runStep(const Step& step, const juce::dsp::AudioBlock<float>& block,
+                            juce::dsp::ProcessorBase* const* processors, size_t numChannels,
+                            uint32_t skipProcessors) noexcept
+{
+    // a skipped processor passes its input through
+    if ((skipProcessors & (1u << step.processor)) != 0)
+        return;
+
+    auto target = step.type == processMain ? block : getScratchBlock(step.scratch, numChannels, block.getNumSamples());
+    auto* processor = processors[step.processor];
+    processor->process(juce::dsp::ProcessContextReplacing<float>(target));
+
+    // a processor that's blown up starts again from silence, and its block
+    // is dropped before it reaches anything else. One that holds the user's
+    // content only loses the block
+    const auto bit = 1u << step.processor;
+    if (SignalGuard::check(target, *kernels) == SignalGuard::tripped)
+    {
+        if ((keepStateMask & bit) == 0)
+            processor->reset();
+
+        target.clear();
+        trippedProcessors.fetch_or(bit);
+    }
+}
+
+void ExecutionPlan::runBranchJob(void* context, int index) noexcept
+{
+    auto& branch = *static_cast<BranchContext*>(context);
+    auto& plan = branch.plan;
+    const auto& job = plan.branchJobs[static_cast<size_t>(branch.step.first + index)];
+
+    for (int step = job.first; step < job.first + job.count; ++step)
+        plan.runStep(plan.branchSteps[static_cast<size_t>(step)], branch.block, branch.processors, branch.numChannels,
+                     branch.skipProcessors);
+}
+
+void ExecutionPlan::process(const juce::dsp::AudioBlock<float>& block,
+                            juce::dsp::ProcessorBase* const* processors,
+                            RealtimeWorkerPool* workers,
+                            uint32_t skipProcessors) noexcept
+{
+    const auto numSamples = block.getNumSamples();
+    const auto numChannels = juce::jmin(block.getNumChannels(), static_cast<size_t>(numScratchChannels));
+    jassert(numSamples <= static_cast<size_t>(scratchBuffers.getNumSamples()) || scratchBuffers.getNumChannels() == 0);
+
+    for (const auto& step : steps)
+    {
+        switch (step.type)
+        {
+            case processMain:
+            case processScratch:
+                runStep(step, block, processors, numChannels, skipProcessors);
+                break;
+
+            case runBranches:
+            {
+                BranchContext context { *this, step, block, processors, numChannels, skipProcessors };
+
+                // short blocks aren't worth waking the workers for
+                if (workers != nullptr && numSamples >= minParallelSamples)
+                    workers->run(runBranchJob, &context, step.count);
+                else
+                    for (int index = 0; index < step.count; ++index)
+                        runBranchJob(&context, index);
+                break;
+            }
+
+            case copyToScratch:
+                getScratchBlock(step.scratch, numChannels, numSamples).copyFrom(block);
+                break;
+
+            case scaleMain:
+                block.multiplyBy(step.gain);
+                break;
+
+            case addScratch:
+                for (size_t channel = 0; channel < numChannels; ++channel)
+                    juce::FloatVectorOperations::addWithMultiply(block.getChannelPointer(channel),
+                        getScratchBlock(step.scratch, numChannels, numSamples).getChannelPointer(channel),
+                        step.gain, static_cast<int>(numSamples));
+                break;
+
+            default:
+                jassertfalse;
+                break;
+        }
+    }
+}
@@ -0,0 +1,193 @@
+/**
+ * @file ExecutionPlan.h
+ * @brief Processor graph description, and the flat plan it's compiled into
+ *
+ * A ProcessingGraph is a list of stages that run one after another. Each stage
+ * is one or more branches of processors: a single branch is a plain serial
+ * run, several branches split the signal, process it side by side and sum
+ * the results, each scaled by its branch mix. A branch with no processors is a
+ * dry path.
+ *
+ * An ExecutionPlan compiles a graph into a flat list of steps plus the scratch
+ * buffers the parallel branches need, so the audio thread only walks an array
+ * and only the processors in the graph ever run. Compiling allocates, so plans
+ * are built off the audio thread and swapped in by the SignalPathManager.
+ *
+ * The branches of a stage don't share processors or buffers, so given a
+ * RealtimeWorkerPool they render at the same time, one job per branch that has
+ * processors. Blocks shorter than minParallelSamples run serially, since
+ * handing them over would cost more than it saves.
+ *
+ * Every processor's block goes through a SignalGuard right after it runs. A
+ * processor whose block trips it (NaN, infinity, runaway feedback) is reset
+ * and its block cleared, so the bad signal goes no further and the rest of
+ * the graph keeps its state. Processors whose state is the user's own (a
+ * recorded loop) are listed in keepStateProcessors and only have their block
+ * cleared.
+ *
+ * Processors run from noexcept code on the audio thread and the worker
+ * threads, so process() must not throw: an exception there terminates.
+ *
+ * @description
+ * stages: Stages of the graph, run in order
+ * branches: Processor runs within a stage, summed with their mix
+ * processors: Processor indices (SignalPathManager::ProcessorIndex) of a branch, run in order
+ * wetOnly: Whether the processors of a branch render their wet signal only (send branches)
+ */
+
+#pragma once
+
+#ifndef EXECUTIONPLAN_H
+#define EXECUTIONPLAN_H
+
+#include <juce_dsp/juce_dsp.h>
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <atomic>
+#include <initializer_list>
+#include <vector>
+#include "../DSPHelpers/RealtimeWorkerPool/RealtimeWorkerPool.h"
+#include "../DSPHelpers/KernelDispatch/KernelDispatch.h"
+
+struct ProcessingGraph
+{
+    struct Branch
+    {
+        std::vector<int> processors;
+        float mix = 1.0f;
+        bool wetOnly = false;
+
+        bool operator==(const Branch& other) const
+        {
+            return processors == other.processors && mix == other.mix && wetOnly == other.wetOnly;
+        }
+    };
+
+    using Stage = std::vector<Branch>;
+    std::vector<Stage> stages;
+
+    // append a serial run of processors
+    ProcessingGraph& then(std::initializer_list<int> processors);
+
+    // append a stage of parallel branches
+    ProcessingGraph& split(std::initializer_list<Branch> branches);
+
+    // append a send stage: each return renders wet only and is summed, times
+    // its mix, onto the stage input scaled by dryLevel
+    ProcessingGraph& sends(std::initializer_list<Branch> returns, float dryLevel = 1.0f);
+
+    // bit per processor index the graph uses
+    [[nodiscard]] uint32_t getProcessorMask() const noexcept;
+
+    // bit per processor index that renders wet only
+    [[nodiscard]] uint32_t getWetOnlyMask() const noexcept;
+
+    // a processor can only appear once in a graph, since it has one state
+    [[nodiscard]] bool isValid() const noexcept;
+
+    bool operator==(const ProcessingGraph& other) const { return stages == other.stages; }
+};
+
+class ExecutionPlan
+{
+public:
+    // shortest block the branches of a stage are rendered in parallel for
+    static constexpr size_t minParallelSamples = 32;
+
+    // compile the graph for blocks up to spec.maximumBlockSize samples
+    // (allocates the scratch buffers, so not from the audio thread). The
+    // processors in keepStateProcessors aren't reset when their guard trips
+    ExecutionPlan(const ProcessingGraph& graph, const juce::dsp::ProcessSpec& spec, uint32_t keepStateProcessors = 0);
+
+    // run every step on the block in place, processors is indexed by the
+    // processor indices in the graph. Parallel branches are shared out over
+    // workers if given one, and the processors in skipProcessors pass their
+    // input straight through (real-time safe)
+    void process(const juce::dsp::AudioBlock<float>& block,
+                 juce::dsp::ProcessorBase* const* processors,
+                 RealtimeWorkerPool* workers = nullptr,
+                 uint32_t skipProcessors = 0) noexcept;
+
+    [[nodiscard]] uint32_t getProcessorMask() const noexcept { return processorMask; }
+    [[nodiscard]] uint32_t getWetOnlyMask() const noexcept { return wetOnlyMask; }
+    [[nodiscard]] const ProcessingGraph& getGraph() const noexcept { return graph; }
+
+    // bit per processor whose guard has tripped since the last call (the
+    // processor has already been reset, unless it keeps its state), and
+    // clear them
+    [[nodiscard]] uint32_t takeTrippedProcessors() noexcept { return trippedProcessors.exchange(0); }
+
+private:
+    enum StepType
+    {
+        processMain,    // run a processor on the main block
+        processScratch, // run a processor on a scratch buffer
+        copyToScratch,  // copy the main block into a scratch buffer
+        scaleMain,      // multiply the main block by the step gain
+        addScratch,     // add a scratch buffer, times the step gain, into the main block
+        runBranches     // render the branches [first, first + count) of a stage
+    };
+
+    struct Step
+    {
+        StepType type;
+        int processor = -1;
+        int scratch = -1;
+        float gain = 1.0f;
+        int first = 0;
+        int count = 0;
+    };
+
+    // the processor steps of one branch, [first, first + count) in branchSteps
+    struct BranchJob
+    {
+        int first = 0;
+        int count = 0;
+    };
+
+    ProcessingGraph graph;
+    std::vector<Step> steps;
+    std::vector<Step> branchSteps;
+    std::vector<BranchJob> branchJobs;
+    uint32_t processorMask = 0;
+    uint32_t wetOnlyMask = 0;
+    uint32_t keepStateMask = 0;
+
+    // one buffer per parallel branch after the first, shared between stages.
+    // The channel pointers are taken once, since the branch jobs look them up
+    // from several threads and getArrayOfWritePointers also marks the buffer
+    juce::AudioBuffer<float> scratchBuffers;
+    float* const* scratchChannels = nullptr;
+    int numScratchChannels = 0;
+
+    // the block scan for this CPU, picked when the plan is compiled
+    const KernelDispatch::Kernels* kernels = nullptr;
+
+    // processors the guards have reset, set from the audio thread and the
+    // branch workers
+    std::atomic<uint32_t> trippedProcessors { 0 };
+
+    [[nodiscard]] juce::dsp::AudioBlock<float> getScratchBlock(int scratch, size_t numChannels, size_t numSamples) noexcept;
+
+    // run a processor step on the main block or its scratch buffer, and
+    // guard what it rendered
+    void runStep(const Step& step, const juce::dsp::AudioBlock<float>& block,
+                 juce::dsp::ProcessorBase* const* processors, size_t numChannels,
+                 uint32_t skipProcessors) noexcept;
+
+    // what a branch job needs, on the audio thread's stack for one runBranches
+    struct BranchContext
+    {
+        ExecutionPlan& plan;
+        const Step& step;
+        const juce::dsp::AudioBlock<float>& block;
+        juce::dsp::ProcessorBase* const* processors;
+        size_t numChannels;
+        uint32_t skipProcessors;
+    };
+
+    static void runBranchJob(void* context, int index) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ExecutionPlan)
+};
+
+#endif //EXECUTIONPLAN_H
@@ -0,0 +1,253 @@
+#include "OutputLimiter.h"
+#include <algorithm>
+
+void OutputLimiter::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    numChannels = static_cast<int>(spec.numChannels);
+    maxBlockSize = static_cast<int>(spec.maximumBlockSize);
+    lookaheadSamples = juce::jmax(1, static_cast<int>(std::ceil(lookaheadSeconds * spec.sampleRate)));
+    latencySamples = lookaheadSamples + detectorDelay;
+
+    // Hann windowed sinc, each phase centred between taps detectorDelay and
+    // detectorDelay + 1 and normalised to unity gain at DC
+    constexpr auto halfLength = static_cast<double>(numTaps / 2);
+    filterGain = 1.0f;
+
+    for (int phase = 1; phase < oversampling; ++phase)
+    {
+        auto& taps = phases[static_cast<size_t>(phase - 1)];
+        double sum = 0.0;
+
+        for (int tap = 0; tap < numTaps; ++tap)
+        {
+            const auto t = detectorDelay + static_cast<double>(phase) / oversampling - tap;
+            const auto sinc = std::sin(juce::MathConstants<double>::pi * t) / (juce::MathConstants<double>::pi * t);
+            const auto window = 0.5 * (1.0 + std::cos(juce::MathConstants<double>::pi * t / halfLength));
+            taps[static_cast<size_t>(tap)] = static_cast<float>(sinc * window);
+            sum += sinc * window;
+        }
+
+        float absoluteSum = 0.0f;
+        for (auto& coefficient : taps)
+        {
+            coefficient = static_cast<float>(coefficient / sum);
+            absoluteSum += std::abs(coefficient);
+        }
+
+        filterGain = juce::jmax(filterGain, absoluteSum);
+    }
+
+    detectBuffer.setSize(numChannels, numTaps - 1 + maxBlockSize);
+    peaks.assign(static_cast<size_t>(maxBlockSize), 0.0f);
+    interpolated.assign(static_cast<size_t>(maxBlockSize), 0.0f);
+    gains.assign(static_cast<size_t>(maxBlockSize), 1.0f);
+
+    delayLine.setSize(numChannels, latencySamples + maxBlockSize);
+
+    // the hold window never has more than lookaheadSamples + 1 gains queued
+    const auto holdCapacity = juce::nextPowerOfTwo(lookaheadSamples + 2);
+    holdGains.assign(static_cast<size_t>(holdCapacity), 1.0f);
+    holdStamps.assign(static_cast<size_t>(holdCapacity), 0);
+    holdMask = holdCapacity - 1;
+
+    releaseCoefficient = static_cast<float>(1.0 - std::exp(-1.0 / (releaseSeconds * spec.sampleRate)));
+    averageWindow.assign(static_cast<size_t>(lookaheadSamples), 1.0f);
+
+    kernels = &KernelDispatch::getKernels(KernelDispatch::selectIsa());
+
+    reset();
+}
+
+void OutputLimiter::release()
+{
+    detectBuffer.setSize(0, 0);
+    delayLine.release();
+
+    std::vector<float>().swap(peaks);
+    std::vector<float>().swap(interpolated);
+    std::vector<float>().swap(gains);
+    std::vector<float>().swap(holdGains);
+    std::vector<juce::int64>().swap(holdStamps);
+    std::vector<float>().swap(averageWindow);
+
+    numChannels = 0;
+    maxBlockSize = 0;
+}
+
+void OutputLimiter::reset() noexcept
+{
+    detectBuffer.clear();
+    delayLine.markEmpty();
+
+    holdFront = 0;
+    holdSize = 0;
+    sampleCounter = 0;
+
+    envelope = 1.0f;
+    std::fill(averageWindow.begin(), averageWindow.end(), 1.0f);
+    averageIndex = 0;
+    averageSum = static_cast<double>(lookaheadSamples);
+    unitySamples = lookaheadSamples;
+    currentGain = 1.0f;
+}
+
+void OutputLimiter::process(const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+    const auto channels = juce::jmin(static_cast<int>(block.getNumChannels()), numChannels);
+    constexpr int history = numTaps - 1;
+
+    jassert(numSamples <= maxBlockSize);
+    jassert(static_cast<int>(block.getNumChannels()) <= numChannels);
+
+    if (numSamples == 0 || channels == 0)
+        return;
+
+    // line the block up behind the samples the filter still needs, and find
+    // out whether any of it could get near the ceiling
+    KernelDispatch::BlockScan found;
+    for (int channel = 0; channel < channels; ++channel)
+    {
+        auto* detect = detectBuffer.getWritePointer(channel);
+        juce::FloatVectorOperations::copy(detect + history, block.getChannelPointer(static_cast<size_t>(channel)), numSamples);
+        found.merge(kernels->scan(detect, history + numSamples));
+    }
+
+    // the guards in front of us have already dropped NaNs and infinities
+    jassert(found.isFinite());
+    const auto hasPeaks = found.getPeak() * filterGain > ceiling;
+
+    if (hasPeaks)
+        measurePeaks(channels, numSamples);
+
+    // keep the end of the block for the next one
+    for (int channel = 0; channel < channels; ++channel)
+    {
+        auto* detect = detectBuffer.getWritePointer(channel);
+        std::copy(detect + numSamples, detect + numSamples + history, detect);
+    }
+
+    // with the gain fully recovered and nothing to limit, the block only
+    // needs delaying
+    const auto isUnity = !hasPeaks && holdSize == 0 && unitySamples >= lookaheadSamples;
+
+    if (isUnity)
+    {
+        sampleCounter += numSamples;
+        currentGain = 1.0f;
+    }
+    else
+        computeGains(hasPeaks, numSamples);
+
+    // delay the audio to meet its gain
+    const auto writePosition = delayLine.getWritePosition();
+    const auto mask = delayLine.getMask();
+    delayLine.touch(writePosition - latencySamples, numSamples + latencySamples);
+
+    for (int channel = 0; channel < channels; ++channel)
+    {
+        auto* samples = block.getChannelPointer(static_cast<size_t>(channel));
+        delayLine.writeBlock(channel, samples, numSamples);
+
+        const auto* delayed = delayLine.getReadPointer(channel);
+        const auto readPosition = writePosition - latencySamples;
+
+        if (isUnity)
+            for (int i = 0; i < numSamples; ++i)
+                samples[i] = delayed[(readPosition + i) & mask];
+        else
+            for (int i = 0; i < numSamples; ++i)
+                samples[i] = delayed[(readPosition + i) & mask] * gains[static_cast<size_t>(i)];
+    }
+
+    delayLine.advanceWritePosition(numSamples);
+}
+
+void OutputLimiter::measurePeaks(int channels, int numSamples) noexcept
+{
+    auto* peak = peaks.data();
+    auto* points = interpolated.data();
+    juce::FloatVectorOperations::clear(peak, numSamples);
+
+    // every loop here runs along the block, so they all vectorise
+    for (int channel = 0; channel < channels; ++channel)
+    {
+        const auto* detect = detectBuffer.getReadPointer(channel);
+
+        // the sample at the end of each interpolated interval
+        for (int i = 0; i < numSamples; ++i)
+            peak[i] = juce::jmax(peak[i], std::abs(detect[i + detectorDelay + 1]));
+
+        // and the points between it and the one before
+        for (const auto& taps : phases)
+        {
+            juce::FloatVectorOperations::clear(points, numSamples);
+            for (int tap = 0; tap < numTaps; ++tap)
+                juce::FloatVectorOperations::addWithMultiply(points, detect + tap, taps[static_cast<size_t>(tap)], numSamples);
+
+            for (int i = 0; i < numSamples; ++i)
+                peak[i] = juce::jmax(peak[i], std::abs(points[i]));
+        }
+    }
+}
+
+void OutputLimiter::computeGains(bool hasPeaks, int numSamples) noexcept
+{
+    const auto holdSamples = static_cast<juce::int64>(lookaheadSamples + 1);
+    const auto averageLength = static_cast<double>(lookaheadSamples);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        ++sampleCounter;
+
+        // drop the gains that have left the hold window
+        while (holdSize > 0 && holdStamps[static_cast<size_t>(holdFront)] <= sampleCounter - holdSamples)
+        {
+            holdFront = (holdFront + 1) & holdMask;
+            --holdSize;
+        }
+
+        // queue the gain this peak needs, the ones in front that are no
+        // lower can't be the minimum any more
+        const auto peak = hasPeaks ? peaks[static_cast<size_t>(i)] : 0.0f;
+        if (peak > ceiling)
+        {
+            const auto needed = ceiling / peak;
+            while (holdSize > 0 && holdGains[static_cast<size_t>((holdFront + holdSize - 1) & holdMask)] >= needed)
+                --holdSize;
+
+            const auto back = static_cast<size_t>((holdFront + holdSize) & holdMask);
+            holdGains[back] = needed;
+            holdStamps[back] = sampleCounter;
+            ++holdSize;
+        }
+
+        const auto held = holdSize > 0 ? holdGains[static_cast<size_t>(holdFront)] : 1.0f;
+
+        // down at once, back up with the release
+        if (held < envelope)
+            envelope = held;
+        else
+            envelope += (held - envelope) * releaseCoefficient;
+
+        if (holdSize == 0 && envelope > 0.99999f)
+            envelope = 1.0f;
+
+        unitySamples = envelope == 1.0f ? juce::jmin(unitySamples + 1, lookaheadSamples) : 0;
+
+        averageSum += envelope - averageWindow[static_cast<size_t>(averageIndex)];
+        averageWindow[static_cast<size_t>(averageIndex)] = envelope;
+        if (++averageIndex == lookaheadSamples)
+            averageIndex = 0;
+
+        gains[static_cast<size_t>(i)] = unitySamples >= lookaheadSamples
+            ? 1.0f
+            : juce::jmin(1.0f, static_cast<float>(averageSum / averageLength));
+    }
+
+    // the running sum drifts, start it again once it's settled at 1
+    if (unitySamples >= lookaheadSamples)
+        averageSum = averageLength;
+
+    currentGain = gains[static_cast<size_t>(numSamples - 1)];
+}
@@ -0,0 +1,138 @@
+/**
+ * @file OutputLimiter.h
+ * @brief Lookahead true-peak limiter at the end of the signal path
+ *
+ * The last stage of the SignalPathManager, so nothing a feedback setting or
+ * a stack of grains does can leave the plugin above the ceiling.
+ *
+ * Peaks are measured between the samples as well as on them: each block is
+ * interpolated at four times the sample rate with a polyphase windowed-sinc
+ * filter, the way a true-peak meter does it, since that's what a DAC
+ * reconstructs. The filter only runs on blocks that could get near the
+ * ceiling, which one vectorised scan of the samples decides (the filter can't
+ * raise a peak by more than its largest phase gain).
+ *
+ * The gain each peak needs is held for lookaheadSamples + 1 and released
+ * exponentially, then averaged over lookaheadSamples, and the audio is
+ * delayed to line up with it. The average reaches the needed gain on the
+ * peak, so the gain never steps, and the limiter never lets a (measured) true
+ * peak through. The delay is reported to the host as latency.
+ *
+ * Everything is allocated in prepare. Once the gain has fully recovered, a
+ * block that's well under the ceiling only goes through the delay line.
+ *
+ * @description
+ * ceiling: Highest true peak let through (-1 dBTP)
+ * lookaheadSeconds: How far ahead the gain starts coming down for a peak
+ * releaseSeconds: Time constant of the gain coming back up after a peak
+ * numTaps: Length of each phase of the interpolation filter
+ * detectorDelay: How many samples late the detector sees a peak (it waits for the samples after it)
+ */
+
+#pragma once
+
+#ifndef OUTPUTLIMITER_H
+#define OUTPUTLIMITER_H
+
+#include <juce_dsp/juce_dsp.h>
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <array>
+#include <vector>
+#include "../DSPHelpers/KernelDispatch/KernelDispatch.h"
+#include "../DSPHelpers/RingBuffer/RingBuffer.h"
+
+class OutputLimiter
+{
+public:
+    static constexpr float ceiling = 0.891251f; // -1 dBTP
+    static constexpr double lookaheadSeconds = 0.0015;
+    static constexpr double releaseSeconds = 0.1;
+
+    static constexpr int oversampling = 4;
+    static constexpr int numTaps = 24;
+    static constexpr int detectorDelay = numTaps / 2 - 1;
+
+    OutputLimiter() = default;
+
+    // allocate the delay line and detector buffers (allocates, not from the
+    // audio thread)
+    void prepare(const juce::dsp::ProcessSpec& spec);
+
+    // free everything until the next prepare
+    void release();
+
+    // forget the audio in flight and recover the gain at once
+    void reset() noexcept;
+
+    // limit a block in place, up to the prepared block size and channel
+    // count. The block comes out getLatencySamples() late (real-time safe)
+    void process(const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    [[nodiscard]] int getLatencySamples() const noexcept { return latencySamples; }
+
+    // the gain applied to the last sample, 1 when nothing's being limited
+    [[nodiscard]] float getCurrentGain() const noexcept { return currentGain; }
+
+private:
+    int numChannels = 0;
+    int maxBlockSize = 0;
+    int lookaheadSamples = 0;
+    int latencySamples = 0;
+
+    // the interpolation filter for the points between the samples, phase 0
+    // is the sample itself so it isn't stored
+    std::array<std::array<float, numTaps>, oversampling - 1> phases {};
+
+    // largest sum of |coefficients| over the phases, the most the filter can
+    // raise a peak by
+    float filterGain = 1.0f;
+
+    // per channel, the last numTaps - 1 samples followed by the block
+    juce::AudioBuffer<float> detectBuffer;
+
+    // per-sample peaks across the channels, one phase of the filter, and the
+    // gains for a block
+    std::vector<float> peaks;
+    std::vector<float> interpolated;
+    std::vector<float> gains;
+
+    // the audio, delayed by latencySamples
+    RingBuffer<float> delayLine;
+
+    // sliding minimum of the needed gain over the hold window: a queue of
+    // (gain, sample) pairs with the gains rising from the front. Gains of 1
+    // aren't queued, so an empty queue holds at 1
+    std::vector<float> holdGains;
+    std::vector<juce::int64> holdStamps;
+    int holdMask = 0;
+    int holdFront = 0;
+    int holdSize = 0;
+    juce::int64 sampleCounter = 0;
+
+    // the held gain after release, and its moving average over lookaheadSamples
+    float envelope = 1.0f;
+    float releaseCoefficient = 0.0f;
+    std::vector<float> averageWindow;
+    int averageIndex = 0;
+    double averageSum = 0.0;
+
+    // samples in a row the envelope has been at 1, once there are
+    // lookaheadSamples of them the average is 1 too
+    int unitySamples = 0;
+
+    float currentGain = 1.0f;
+
+    // the block scan for this CPU, picked in prepare
+    const KernelDispatch::Kernels* kernels = nullptr;
+
+    // fill peaks with the true peak around each sample of the block
+    // (numSamples past the history in detectBuffer)
+    void measurePeaks(int channels, int numSamples) noexcept;
+
+    // fill gains for the block from the needed gains (ceiling / peak)
+    void computeGains(bool hasPeaks, int numSamples) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OutputLimiter)
+};
+
+#endif //OUTPUTLIMITER_H
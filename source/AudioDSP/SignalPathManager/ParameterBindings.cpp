@@ -0,0 +1,103 @@
+#include "ParameterBindings.h"
+
+void ParameterBindings::bind(const juce::AudioProcessorValueTreeState& apvts)
+{
+    bound = true;
+
+    for (size_t i = 0; i < pointers.size(); ++i)
+    {
+        pointers[i] = apvts.getRawParameterValue(parameterIds[i]);
+
+        // every id above must exist in PluginProcessor::createParams
+        jassert(pointers[i] != nullptr);
+        bound = bound && pointers[i] != nullptr;
+    }
+
+    // push everything on the first update after binding
+    firstUpdate = true;
+}
+
+uint32_t ParameterBindings::update() noexcept
+{
+    if (! bound)
+        return 0;
+
+    const auto isFirstUpdate = firstUpdate;
+    uint32_t dirty = isFirstUpdate ? static_cast<uint32_t>(allGroups) : 0u;
+    firstUpdate = false;
+
+    for (size_t i = 0; i < pointers.size(); ++i)
+    {
+        // only a change on the host's side replaces a setValue override
+        const auto value = pointers[i]->load(std::memory_order_relaxed);
+        if (value == hostValues[i] && ! isFirstUpdate)
+            continue;
+
+        hostValues[i] = value;
+        if (value != values[i])
+        {
+            values[i] = value;
+            dirty |= parameterGroups[i];
+        }
+    }
+
+    return dirty;
+}
+
+int ParameterBindings::findParameter(const juce::String& parameterId)
+{
+    for (size_t i = 0; i < parameterIds.size(); ++i)
+        if (parameterId == parameterIds[i])
+            return static_cast<int>(i);
+    return -1;
+}
+
+uint32_t ParameterBindings::setValue(int index, float value) noexcept
+{
+    jassert(index >= 0 && index < numParameters);
+
+    auto& current = values[static_cast<size_t>(index)];
+    if (value == current)
+        return 0;
+
+    current = value;
+    return parameterGroups[static_cast<size_t>(index)];
+}
+
+DelayProcessor::DelayParams ParameterBindings::getDelayParams() const noexcept
+{
+    DelayProcessor::DelayParams params;
+    params.delayTime = get(delayTime);
+    params.feedback = get(feedback);
+    params.wetLevel = get(wetDry);
+    return params;
+}
+
+ReverbProcessor::ReverbParams ParameterBindings::getReverbParams() const noexcept
+{
+    ReverbProcessor::ReverbParams params;
+    params.roomSize = get(reverbRoomSize);
+    params.damping = get(reverbDamping);
+    params.wetLevel = get(reverbMix);
+    params.dryLevel = 1.0f - get(reverbMix);
+    params.width = get(reverbWidth);
+    params.freezeMode = get(reverbFreeze);
+    params.toneCutoff = get(reverbTone);
+    return params;
+}
+
+GranularProcessor::GranularParams ParameterBindings::getGranularParams() const noexcept
+{
+    GranularProcessor::GranularParams params;
+    params.delayTime = get(granularDelayTime);
+    params.grainSize = get(grainSize);
+    params.grainDensity = get(grainDensity);
+    params.pitchShift = get(pitchShift);
+    params.feedback = get(granularFeedback);
+    params.wetDryMix = get(granularWetDry);
+    params.spread = get(spread);
+    params.windowType = static_cast<int>(get(grainWindow));
+    params.interpolationQuality = static_cast<int>(get(grainQuality));
+    params.scatter = get(grainScatter);
+    return params;
+}
@@ -0,0 +1,157 @@
+/**
+ * @file ParameterBindings.h
+ * @brief Flat snapshot of every processor parameter, resolved once from the APVTS
+ *
+ * All std::atomic<float>* parameter pointers are looked up by ID once in bind(),
+ * so the audio thread never hashes a parameter string. Each block, update()
+ * loads every pointer, compares it with the last value it saw and returns a
+ * bitmask of the processor groups whose parameters actually changed, so the
+ * SignalPathManager only pushes new structs to those processors.
+ *
+ * setValue() overrides a value from inside a block, for timestamped events
+ * like MIDI controllers. The override holds until the host or the editor moves
+ * that parameter again, update() only takes values that changed on their side.
+ *
+ * The looper's transport isn't a continuous parameter, every button press has
+ * to arrive, so it goes through the SignalPathManager's command queue instead.
+ *
+ * @description
+ * Group: One bit per processor that owns parameters (delay, reverb, granular)
+ */
+
+#pragma once
+
+#ifndef PARAMETERBINDINGS_H
+#define PARAMETERBINDINGS_H
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <array>
+#include <atomic>
+
+#include "../Granular-Delay/GranularProcessor.h"
+#include "../Reverb/ReverbProcessor.h"
+#include "../Standard-Delay/DelayProcessor.h"
+
+class ParameterBindings
+{
+public:
+    // one dirty bit per processor that owns parameters
+    // TODO: PROCESSOR_ADDITION_CHAIN(25): add a group bit for the new processor
+    enum Group : uint32_t
+    {
+        delayGroup = 1u << 0,
+        reverbGroup = 1u << 1,
+        granularGroup = 1u << 2,
+        allGroups = delayGroup | reverbGroup | granularGroup
+    };
+
+    ParameterBindings() = default;
+
+    // resolve every parameter pointer by ID (call once, off the audio thread)
+    void bind(const juce::AudioProcessorValueTreeState& apvts);
+
+    [[nodiscard]] bool isBound() const noexcept { return bound; }
+
+    // load all bound parameters and return the groups whose values changed
+    // since the last call (lock-free, no string lookups)
+    uint32_t update() noexcept;
+
+    // index of a bound parameter by ID for setValue, -1 if it isn't one
+    [[nodiscard]] static int findParameter(const juce::String& parameterId);
+
+    // override one parameter in the snapshot (audio thread) and return its
+    // group if the value changed, 0 otherwise
+    uint32_t setValue(int index, float value) noexcept;
+
+    // build parameter structs from the latest snapshot
+    [[nodiscard]] DelayProcessor::DelayParams getDelayParams() const noexcept;
+    [[nodiscard]] ReverbProcessor::ReverbParams getReverbParams() const noexcept;
+    [[nodiscard]] GranularProcessor::GranularParams getGranularParams() const noexcept;
+
+private:
+    // flat parameter index, ids and groups below must stay in this order
+    // TODO: PROCESSOR_ADDITION_CHAIN(26): add an index, id and group for each
+    //       new parameter here
+    enum ParameterIndex
+    {
+        delayTime,
+        feedback,
+        wetDry,
+        reverbRoomSize,
+        reverbDamping,
+        reverbMix,
+        reverbWidth,
+        reverbFreeze,
+        reverbTone,
+        granularDelayTime,
+        grainSize,
+        grainDensity,
+        pitchShift,
+        granularFeedback,
+        granularWetDry,
+        spread,
+        grainWindow,
+        grainQuality,
+        grainScatter,
+        numParameters
+    };
+
+    static constexpr std::array<const char*, numParameters> parameterIds {
+        "delayTime",
+        "feedback",
+        "wetDry",
+        "reverbRoomSize",
+        "reverbDamping",
+        "reverbMix",
+        "reverbWidth",
+        "reverbFreeze",
+        "reverbTone",
+        "granularDelayTime",
+        "grainSize",
+        "grainDensity",
+        "pitchShift",
+        "granularFeedback",
+        "granularWetDry",
+        "spread",
+        "grainWindow",
+        "grainQuality",
+        "grainScatter"
+    };
+
+    static constexpr std::array<uint32_t, numParameters> parameterGroups {
+        delayGroup,
+        delayGroup,
+        delayGroup,
+        reverbGroup,
+        reverbGroup,
+        reverbGroup,
+        reverbGroup,
+        reverbGroup,
+        reverbGroup,
+        granularGroup,
+        granularGroup,
+        granularGroup,
+        granularGroup,
+        granularGroup,
+        granularGroup,
+        granularGroup,
+        granularGroup,
+        granularGroup,
+        granularGroup
+    };
+
+    [[nodiscard]] float get(ParameterIndex index) const noexcept { return values[static_cast<size_t>(index)]; }
+
+    std::array<std::atomic<float>*, numParameters> pointers {};
+    std::array<float, numParameters> values {};
+
+    // what update() last loaded, values differ from it where setValue has
+    // overridden a parameter since
+    std::array<float, numParameters> hostValues {};
+    bool bound = false;
+    bool firstUpdate = true;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParameterBindings)
+};
+
+#endif //PARAMETERBINDINGS_H
@@ -0,0 +1,216 @@
+#include "PathTransition.h"
+
+void PathTransition::prepare(const juce::dsp::ProcessSpec& spec, double fadeSeconds)
+{
+    jassert(fadeSeconds >= 0.0);
+
+    fadeSamples = juce::jmax(0, static_cast<int>(std::round(fadeSeconds * spec.sampleRate)));
+    maxTailSamples = static_cast<int>(maxTailSeconds * spec.sampleRate);
+    silenceHoldSamples = static_cast<int>(silenceHoldSeconds * spec.sampleRate);
+
+    // a quarter sine, so fadeIn² + fadeOut² = 1 all the way through
+    fadeTable.resize(static_cast<size_t>(fadeSamples) + 1);
+    for (int i = 0; i <= fadeSamples; ++i)
+        fadeTable[static_cast<size_t>(i)] = fadeSamples == 0 ? 1.0f
+            : std::sin(juce::MathConstants<float>::halfPi * static_cast<float>(i) / static_cast<float>(fadeSamples));
+
+    outgoingBuffer.setSize(fadeSamples > 0 ? static_cast<int>(spec.numChannels) : 0,
+                           fadeSamples > 0 ? static_cast<int>(spec.maximumBlockSize) : 0);
+    outgoingChannels = outgoingBuffer.getArrayOfWritePointers();
+
+    phase = idle;
+}
+
+void PathTransition::release()
+{
+    phase = idle;
+    fadeSamples = 0;
+    fadeTable.clear();
+    fadeTable.shrink_to_fit();
+    outgoingBuffer.setSize(0, 0);
+    outgoingChannels = nullptr;
+}
+
+void PathTransition::start(Start how, bool withTail) noexcept
+{
+    jassert(isEnabled());
+    jassert(withTail || how == fadeIn);
+
+    phase = how == crossfade ? crossfading : fadingIn;
+    position = 0;
+    silentSamples = 0;
+    releaseRequested = false;
+    hasTail = withTail;
+}
+
+void PathTransition::startDuck() noexcept
+{
+    jassert(isEnabled());
+
+    phase = ducking;
+    position = 0;
+    releaseRequested = false;
+}
+
+void PathTransition::requestRelease() noexcept
+{
+    // a crossfade or fade in runs to the end first, then goes straight to
+    // the release
+    releaseRequested = true;
+
+    if (phase == decaying)
+    {
+        phase = releasing;
+        position = 0;
+    }
+}
+
+juce::dsp::AudioBlock<float> PathTransition::beginBlock(const juce::dsp::AudioBlock<float>& input) noexcept
+{
+    jassert(isActive());
+
+    const auto numSamples = input.getNumSamples();
+    const auto numChannels = juce::jmin(input.getNumChannels(), static_cast<size_t>(outgoingBuffer.getNumChannels()));
+    jassert(numSamples <= static_cast<size_t>(outgoingBuffer.getNumSamples()));
+
+    juce::dsp::AudioBlock<float> outgoing(outgoingChannels, numChannels, numSamples);
+
+    // after the crossfade the outgoing processors only ring out
+    if (phase != crossfading)
+    {
+        outgoing.clear();
+        return outgoing;
+    }
+
+    for (size_t channel = 0; channel < numChannels; ++channel)
+    {
+        const auto* source = input.getChannelPointer(channel);
+        auto* destination = outgoing.getChannelPointer(channel);
+
+        for (size_t i = 0; i < numSamples; ++i)
+            destination[i] = source[i] * getFadeOut(position + static_cast<int>(i));
+    }
+
+    return outgoing;
+}
+
+bool PathTransition::endBlock(const juce::dsp::AudioBlock<float>& output, const juce::dsp::AudioBlock<float>& outgoing) noexcept
+{
+    const auto numSamples = static_cast<int>(output.getNumSamples());
+    const auto numChannels = output.getNumChannels();
+
+    switch (phase)
+    {
+        case ducking:
+        {
+            for (size_t channel = 0; channel < numChannels; ++channel)
+            {
+                auto* destination = output.getChannelPointer(channel);
+
+                for (int i = 0; i < numSamples; ++i)
+                    destination[i] *= getFadeOut(position + i);
+            }
+
+            position = juce::jmin(position + numSamples, fadeSamples);
+            return false;
+        }
+
+        case fadingIn:
+        {
+            for (size_t channel = 0; channel < numChannels; ++channel)
+            {
+                auto* destination = output.getChannelPointer(channel);
+                const auto* tail = channel < outgoing.getNumChannels() ? outgoing.getChannelPointer(channel) : nullptr;
+
+                for (int i = 0; i < numSamples; ++i)
+                    destination[i] = (destination[i] + (tail != nullptr ? tail[i] : 0.0f)) * getFadeIn(position + i);
+            }
+
+            position += numSamples;
+            if (position >= fadeSamples)
+            {
+                phase = !hasTail ? idle : releaseRequested ? releasing : decaying;
+                position = 0;
+                return phase == idle;
+            }
+            return false;
+        }
+
+        case crossfading:
+        {
+            for (size_t channel = 0; channel < numChannels; ++channel)
+            {
+                auto* destination = output.getChannelPointer(channel);
+                const auto* tail = channel < outgoing.getNumChannels() ? outgoing.getChannelPointer(channel) : nullptr;
+
+                for (int i = 0; i < numSamples; ++i)
+                    destination[i] = destination[i] * getFadeIn(position + i) + (tail != nullptr ? tail[i] : 0.0f);
+            }
+
+            position += numSamples;
+            if (position >= fadeSamples)
+            {
+                phase = releaseRequested ? releasing : decaying;
+                position = 0;
+            }
+            return false;
+        }
+
+        case decaying:
+        {
+            float peak = 0.0f;
+
+            for (size_t channel = 0; channel < outgoing.getNumChannels() && channel < numChannels; ++channel)
+            {
+                const auto* tail = outgoing.getChannelPointer(channel);
+                juce::FloatVectorOperations::add(output.getChannelPointer(channel), tail, numSamples);
+
+                float low, high;
+                juce::FloatVectorOperations::findMinAndMax(tail, numSamples, low, high);
+                peak = juce::jmax(peak, -low, high);
+            }
+
+            silentSamples = peak < silenceLevel ? silentSamples + numSamples : 0;
+            if (silentSamples >= silenceHoldSamples)
+            {
+                phase = idle;
+                return true;
+            }
+
+            // a tail that won't die down (a frozen reverb, a delay at full
+            // feedback) is faded out instead
+            position += numSamples;
+            if (position >= maxTailSamples)
+            {
+                phase = releasing;
+                position = 0;
+            }
+            return false;
+        }
+
+        case releasing:
+        {
+            for (size_t channel = 0; channel < outgoing.getNumChannels() && channel < numChannels; ++channel)
+            {
+                auto* destination = output.getChannelPointer(channel);
+                const auto* tail = outgoing.getChannelPointer(channel);
+
+                for (int i = 0; i < numSamples; ++i)
+                    destination[i] += tail[i] * getFadeOut(position + i);
+            }
+
+            position += numSamples;
+            if (position >= fadeSamples)
+            {
+                phase = idle;
+                return true;
+            }
+            return false;
+        }
+
+        case idle:
+        default:
+            jassertfalse;
+            return true;
+    }
+}
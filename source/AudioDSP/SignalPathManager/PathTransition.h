@@ -0,0 +1,132 @@
+/**
+ * @file PathTransition.h
+ * @brief Equal-power crossfade, or duck and switch, from an outgoing to an incoming signal path, with the outgoing tails left to decay
+ *
+ * While a crossfade runs, the outgoing path is fed its own copy of the input
+ * and the incoming path processes the block as usual. Rather than fading the
+ * outgoing path's output, its input is faded out (cosine) while the incoming
+ * output is faded in (sine), so the outgoing dry signal crossfades with equal
+ * power but anything the outgoing processors already hold (delay lines,
+ * reverb tails) keeps ringing at full level. Once the crossfade is done the
+ * outgoing path is fed silence and its output added until it stays below
+ * silenceLevel for silenceHoldSeconds, or until maxTailSeconds have passed or
+ * a release is requested, in which case the tail is faded out over one fade
+ * length.
+ *
+ * Two paths that share a processor can't both run it, since it has one
+ * state, so they can't be crossfaded. Those switch with a duck instead: the
+ * current path's output fades out (cosine) before the switch, then the
+ * incoming output fades back in (sine) along with the outgoing tails, which
+ * then decay as above.
+ *
+ * Everything is allocated in prepare, and outside a transition nothing here
+ * runs at all.
+ *
+ * @description
+ * fadeSamples: Length of the crossfade (and of a tail release), 0 switches instantly
+ * maxTailSeconds: Longest an outgoing tail may ring before it's released (a frozen reverb never decays)
+ * silenceLevel: Peak level below which an outgoing tail counts as finished
+ * silenceHoldSeconds: How long a tail has to stay below silenceLevel, a delay line can be quiet between echoes
+ */
+
+#pragma once
+
+#ifndef PATHTRANSITION_H
+#define PATHTRANSITION_H
+
+#include <juce_dsp/juce_dsp.h>
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <vector>
+
+class PathTransition
+{
+public:
+    static constexpr double maxTailSeconds = 10.0;
+    static constexpr float silenceLevel = 1.0e-4f; // -80 dB
+    static constexpr double silenceHoldSeconds = 1.0;
+
+    PathTransition() = default;
+
+    // allocate the outgoing path's buffer and the fade table (not from the
+    // audio thread)
+    void prepare(const juce::dsp::ProcessSpec& spec, double fadeSeconds);
+
+    // free everything until the next prepare
+    void release();
+
+    // whether transitions are enabled (prepared with a non-zero fade time)
+    [[nodiscard]] bool isEnabled() const noexcept { return fadeSamples > 0; }
+
+    enum Start
+    {
+        crossfade, // both paths render, the outgoing input fades out as the incoming output fades in
+        fadeIn     // after a duck, the incoming output and the outgoing tails fade in together
+    };
+
+    // start a transition to a new path (audio thread). Without a tail there's
+    // no outgoing path, and a fade in ends the transition
+    void start(Start how, bool withTail = true) noexcept;
+
+    // fade the current path's output out ahead of a switch (audio thread),
+    // endBlock is then called with no outgoing block
+    void startDuck() noexcept;
+
+    [[nodiscard]] bool isActive() const noexcept { return phase != idle; }
+    [[nodiscard]] bool isDucking() const noexcept { return phase == ducking; }
+
+    // whether the duck has faded all the way out, so the path can be switched
+    [[nodiscard]] bool isDucked() const noexcept { return phase == ducking && position >= fadeSamples; }
+
+    // fade the outgoing tail out instead of waiting for it to decay, e.g.
+    // because another path is waiting to be switched in
+    void requestRelease() noexcept;
+
+    // copy the block into the outgoing path's buffer with its input fade
+    // applied, and return the part of the buffer to process it in
+    juce::dsp::AudioBlock<float> beginBlock(const juce::dsp::AudioBlock<float>& input) noexcept;
+
+    // fade the incoming path's output in and add the outgoing path's output
+    // (after both have processed the block), or fade the current path's
+    // output out while ducking. Returns true once the transition has finished
+    bool endBlock(const juce::dsp::AudioBlock<float>& output, const juce::dsp::AudioBlock<float>& outgoing) noexcept;
+
+private:
+    enum Phase
+    {
+        idle,
+        ducking,     // current output fades out, then stays silent until the switch
+        crossfading, // outgoing input fades out, incoming output fades in
+        fadingIn,    // incoming output and outgoing tail fade in
+        decaying,    // outgoing path fed silence, its tail added at full level
+        releasing    // tail fading out
+    };
+
+    Phase phase = idle;
+    bool releaseRequested = false;
+    bool hasTail = true;
+
+    // samples into the current phase
+    int position = 0;
+
+    // samples the tail has been below silenceLevel for
+    int silentSamples = 0;
+
+    int fadeSamples = 0;
+    int maxTailSamples = 0;
+    int silenceHoldSamples = 0;
+
+    // sin over a quarter period, fadeSamples + 1 entries: fadeTable[i] is the
+    // incoming gain and fadeTable[fadeSamples - i] the outgoing one
+    std::vector<float> fadeTable;
+
+    // input copy for the outgoing path, channel pointers taken once in prepare
+    juce::AudioBuffer<float> outgoingBuffer;
+    float* const* outgoingChannels = nullptr;
+
+    [[nodiscard]] float getFadeIn(int sample) const noexcept { return fadeTable[static_cast<size_t>(juce::jlimit(0, fadeSamples, sample))]; }
+    [[nodiscard]] float getFadeOut(int sample) const noexcept { return getFadeIn(fadeSamples - sample); }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PathTransition)
+};
+
+#endif //PATHTRANSITION_H
@@ -6,12 +6,18 @@
 
 SignalPathManager::SignalPathManager() : currentSpec()
 {
-    // empty constructor
+    // TODO: PROCESSOR_ADDITION_CHAIN(12): add the new processor at its index
+    processors[looper] = &looperProcessor;
+    processors[delay] = &delayProcessor;
+    processors[granular] = &granularProcessor;
+    processors[reverb] = &reverbProcessor;
 }
 
 SignalPathManager::~SignalPathManager()
 {
-    // empty destructor
+    // the warm-up thread mustn't outlive the processors it prepares
+    warmUpThread.stopThread(warmUpStopTimeoutMs);
+    clearPaths();
 }
 
 void SignalPathManager::prepare(const juce::dsp::ProcessSpec& spec)
@@ -19,42 +25,101 @@ void SignalPathManager::prepare(const juce::dsp::ProcessSpec& spec)
     //=error handling===========================================================
     jassert(spec.sampleRate > 0.0);
     jassert(spec.maximumBlockSize > 0.0);
-    jassert(spec.numChannels > 0 && spec.numChannels <= 8);
+    jassert(spec.numChannels > 0 && spec.numChannels <= static_cast<juce::uint32>(maxChannels));
 
-    if (spec.sampleRate <= 0.0 || spec.maximumBlockSize <= 0.0 || spec.numChannels <= 0)
+    if (spec.sampleRate <= 0.0 || spec.maximumBlockSize <= 0.0 || spec.numChannels <= 0
+        || spec.numChannels > static_cast<juce::uint32>(maxChannels))
     {
         throw std::invalid_argument("Invalid ProcessSpec in SignalPathManager");
     }
     //=end error handling=======================================================
 
+    // the warm-up thread prepares with currentSpec, so stop it while that changes
+    warmUpThread.stopThread(warmUpStopTimeoutMs);
+
     // store the spec for later use
     currentSpec = spec;
+    reverbProcessor.setChannelLayout(channelLayout);
+    granularProcessor.setChannelLayout(channelLayout);
+    granularProcessor.setMaxGrains(maxGrains);
+
+    // start (or resize) the worker pool, the audio isn't running yet
+    if (numWorkerThreads == 0)
+        workerPool.reset();
+    else if (workerPool == nullptr || workerPool->getNumWorkers() != numWorkerThreads)
+        workerPool = std::make_unique<RealtimeWorkerPool>(numWorkerThreads);
+
+    transition.prepare(spec, transitionSeconds);
+    outputLimiter.prepare(spec);
+    kernels = &KernelDispatch::getKernels(KernelDispatch::selectIsa());
+    numGuardTrips = 0;
+
+    // prepare only the processors the requested graph reaches, and compile
+    // its plan straight away, there's no audio running to hand over from
+    initializeProcessors();
+
+    warmUpThread.startThread(juce::Thread::Priority::background);
+}
+
+void SignalPathManager::releaseResources()
+{
+    warmUpThread.stopThread(warmUpStopTimeoutMs);
 
-    // initialize the processor chain
-    if (!processorChain)
+    // the plans hold scratch buffers sized for the old spec
+    clearPaths();
+    activeProcessors = 0;
+    outgoingProcessors = 0;
+
+    workerPool.reset();
+    transition.release();
+    outputLimiter.release();
+
+    for (int index = 0; index < numProcessors; ++index)
     {
-        processorChain = std::make_unique<MainChainType>();
-        initializeProcessorChain();
+        withProcessor(static_cast<ProcessorIndex>(index), [](auto& processor) { processor.releaseResources(); });
+        resourceStates[static_cast<size_t>(index)] = released;
     }
+    processorsInUse = 0;
+}
+
+void SignalPathManager::setNumWorkerThreads(int newNumWorkerThreads)
+{
+    jassert(newNumWorkerThreads >= 0);
+    numWorkerThreads = juce::jmax(0, newNumWorkerThreads);
+}
+
+void SignalPathManager::setMaxGrains(int newMaxGrains)
+{
+    jassert(newMaxGrains > 0);
+    maxGrains = juce::jmax(1, newMaxGrains);
+}
 
-    // make sure all processors in the chain are properly prepared
-    processorChain->prepare(spec);
+void SignalPathManager::setChannelLayout(const juce::AudioChannelSet& newLayout)
+{
+    channelLayout = newLayout;
+}
 
-    // set up active processors based on current mode
-    updateActiveProcessors();
+void SignalPathManager::setTransitionTime(double newTransitionSeconds)
+{
+    jassert(newTransitionSeconds >= 0.0);
+    transitionSeconds = juce::jmax(0.0, newTransitionSeconds);
 }
 
 void SignalPathManager::reset()
 {
-    // reset the main processor chain if it exists
-    if (processorChain)
-        processorChain->reset();
+    // processors that aren't in use may be in the middle of being prepared
+    // or released, so they're reset when they're next switched in instead
+    const auto inUse = processorsInUse.load();
+    for (int index = 0; index < numProcessors; ++index)
+    {
+        const auto bit = 1u << index;
+        if ((inUse & bit) != 0)
+            withProcessor(static_cast<ProcessorIndex>(index), [](auto& processor) { processor.reset(); });
+        else
+            staleProcessors |= bit;
+    }
 
-    // TODO: PROCESSOR_ADDITION_CHAIN(13): add reset logic for any new chains
-    //       here. remember that we are using one main chain to handle all of
-    //       the processors, so calling reset on the main chain should be fine
-    //       unless you're adding a whole new chain that needs separate logic
-    //       to reset it.
+    outputLimiter.reset();
 }
 
 void SignalPathManager::process(const juce::dsp::ProcessContextReplacing<float>& context)
@@ -76,194 +141,600 @@ void SignalPathManager::process(const juce::dsp::ProcessContextReplacing<float>&
     }
     //=end error handling=======================================================
 
-    if (processorChain)
+    // hand over to a newly compiled plan once its processors are warmed up,
+    // then apply the commands queued since the last block
+    applyPendingPath();
+    applyCommands();
+
+    // a host that sends NaNs or a blown up signal gets silence back, rather
+    // than every processor tripping its guard on it
+    if (SignalGuard::check(outputBlock, *kernels) == SignalGuard::tripped)
+        outputBlock.clear();
+
+    if (activePath)
     {
-        //=wrap in try-catch to ensure the processorChain is initialized========
-        try
+        // the plans run the processors noexcept, a processor must not throw
+        // on the audio thread (see ExecutionPlan.h)
+        if (outgoingPath != nullptr && transition.isActive())
         {
-            // apply bypass states for all processors using our helper function
-            setProcessorBypassStates(*processorChain);
+            // the old plan runs on its own copy of the input, leaving out
+            // the processors that have moved to the new one
+            const auto outgoingBlock = transition.beginBlock(outputBlock);
+            outgoingPath->plan.process(outgoingBlock, processors.data(), workerPool.get(), activeProcessors);
+            activePath->plan.process(outputBlock, processors.data(), workerPool.get());
+            transition.endBlock(outputBlock, outgoingBlock);
+        }
+        else
+        {
+            activePath->plan.process(outputBlock, processors.data(), workerPool.get());
 
-            processorChain->process(context);
+            // ducking ahead of a switch, or fading in after one with no
+            // tails to keep
+            if (transition.isActive())
+                transition.endBlock(outputBlock, {});
         }
 
-        catch (const std::exception& e)
+        collectGuardTrips();
+        outputLimiter.process(outputBlock);
+        updateTailLength();
+    }
+    else
+        jassertfalse; // no plan compiled, prepare hasn't been called
+}
+
+void SignalPathManager::collectGuardTrips() noexcept
+{
+    auto tripped = activePath->plan.takeTrippedProcessors();
+    if (outgoingPath != nullptr)
+        tripped |= outgoingPath->plan.takeTrippedProcessors();
+
+    if (tripped != 0)
+        numGuardTrips += juce::countNumberOfBits(tripped);
+}
+
+void SignalPathManager::processWithEvents(const juce::dsp::ProcessContextReplacing<float>& context,
+                                          const TimedEvent* events, int numEvents)
+{
+    auto& block = context.getOutputBlock();
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+
+    int start = 0;
+    int next = 0;
+
+    while (start < numSamples)
+    {
+        // apply the events due at the start of this sub-block and end it at
+        // the next one that's far enough away. Splits stay minSubBlockSamples
+        // from the end too, so the last sub-block isn't a sliver either
+        auto end = numSamples;
+        for (; next < numEvents; ++next)
         {
-            DBG("Error in signal processing: " << e.what());
-            outputBlock.clear(); //safe fallback
+            jassert(next == 0 || events[next].sampleOffset >= events[next - 1].sampleOffset);
+
+            const auto split = juce::jmin(events[next].sampleOffset, numSamples - minSubBlockSamples);
+            if (split - start >= minSubBlockSamples)
+            {
+                end = split;
+                break;
+            }
+
+            applyEvent(events[next]);
         }
+
+        pushParameterGroups();
+
+        auto subBlock = block.getSubBlock(static_cast<size_t>(start), static_cast<size_t>(end - start));
+        process(juce::dsp::ProcessContextReplacing<float>(subBlock));
+        start = end;
+    }
+}
+
+void SignalPathManager::applyEvent(const TimedEvent& event) noexcept
+{
+    switch (event.type)
+    {
+        case TimedEvent::parameterValue:
+            pendingParameterGroups |= parameterBindings.setValue(event.parameter, event.value);
+            break;
+
+        case TimedEvent::looperState:
+            // queued behind any earlier presses, process() applies it
+            setLooperState(static_cast<int>(event.value));
+            break;
+
+        default:
+            jassertfalse;
+            break;
     }
-    else
-        jassertfalse; // no processor chain initialized, should never happen
 }
 
 void SignalPathManager::setProcessingMode(ProcessingMode newMode)
 {
-    // avoid reinitializing if the mode hasn't changed
-    if (currentMode == newMode)
-        return;
+    // this can be called from the audio thread by a parameter listener, so it
+    // only records the request. The warm-up thread prepares the new mode's
+    // processors and compiles its plan, and applyPendingPath switches over at
+    // a block boundary
+    jassert(newMode != Custom); // use setGraph
+    requestedMode = newMode;
+}
 
-    currentMode = newMode;
+bool SignalPathManager::setGraph(const ProcessingGraph& newGraph)
+{
+    if (!newGraph.isValid() || newGraph.getProcessorMask() >= (1u << numProcessors)
+        || (newGraph.getWetOnlyMask() & ~wetOnlyProcessors) != 0)
+    {
+        jassertfalse;
+        return false;
+    }
+
+    {
+        const juce::ScopedLock sl(customGraphLock);
+        customGraph = newGraph;
+        ++customGraphVersion;
+    }
+
+    requestedMode = Custom;
+    return true;
+}
+
+bool SignalPathManager::setLooperState(int newState)
+{
+    jassert(newState >= LooperProcessor::Recording && newState <= LooperProcessor::Clear);
+
+    if (commands.push({ Command::looperState, newState }))
+        return true;
+
+    jassertfalse; // the audio thread hasn't drained the queue in a long time
+    return false;
+}
+
+void SignalPathManager::applyCommands() noexcept
+{
+    Command command;
+    while (commands.pop(command))
+    {
+        switch (command.type)
+        {
+            case Command::looperState:
+                // an inactive looper only needs to end up in the latest state
+                if (auto* looper = getLooperProcessor())
+                    looper->setState(command.value);
+                else
+                    pendingLooperState = command.value;
+                break;
+
+            default:
+                jassertfalse;
+                break;
+        }
+    }
 
-    // update which processors are active based on the new mode
-    updateActiveProcessors();
+    if (pendingLooperState >= 0)
+    {
+        if (auto* looper = getLooperProcessor())
+        {
+            looper->setState(pendingLooperState);
+            pendingLooperState = -1;
+        }
+    }
 }
 
-// TODO: PROCESSOR_ADDITION_CHAIN(14): add new processor *chain* getters here
-// helper methods to get processor references from the main chain
-// Template-based processor getter usage examples
-DelayProcessor& SignalPathManager::getDelayFromChain()
+ProcessingGraph SignalPathManager::getGraphForMode(ProcessingMode mode)
 {
-    return getProcessorFromChain<DelayProcessor, delay>();
+    // TODO: PROCESSOR_ADDITION_CHAIN(22): add the new processor to the graphs
+    //       of the modes that use it in the switch statement below
+
+    ProcessingGraph graph;
+
+    switch (mode)
+    {
+        case DelayOnly:
+            return graph.then({ delay });
+
+        case ReverbOnly:
+            return graph.then({ reverb });
+
+        case GranularOnly:
+            return graph.then({ granular });
+
+        case LooperOnly:
+            return graph.then({ looper });
+
+        case Serial:
+            // all processors are active in serial mode, except for the standard
+            // delay, because it's not necessary with the granular delay
+            // processor
+            // TODO: PROCESSOR_ADDITION_CHAIN(24): add new processors here
+            return graph.then({ looper, granular, reverb });
+
+        case Parallel:
+            // the looper feeds both delays side by side, and the sum of the
+            // two goes into the reverb
+            return graph.then({ looper })
+                        .split({ { { delay }, 0.5f }, { { granular }, 0.5f } })
+                        .then({ reverb });
+
+        case SendReturn:
+            // the looper feeds a send to each effect, and their returns are
+            // summed onto the dry looper output
+            // TODO: PROCESSOR_ADDITION_CHAIN(29): add new effects as sends here
+            return graph.then({ looper })
+                        .sends({ { { delay } }, { { granular } }, { { reverb } } });
+
+        case Custom:
+        default:
+            // use DelayOnly as a fallback
+            jassertfalse; // unexpected mode, should never happen
+            return graph.then({ delay });
+    }
 }
 
-ReverbProcessor& SignalPathManager::getReverbFromChain()
+ProcessingGraph SignalPathManager::getRequestedGraph(ProcessingMode& mode, uint32_t& version)
 {
-    return getProcessorFromChain<ReverbProcessor, reverb>();
+    mode = static_cast<ProcessingMode>(requestedMode.load());
+
+    if (mode != Custom)
+    {
+        version = 0;
+        return getGraphForMode(mode);
+    }
+
+    const juce::ScopedLock sl(customGraphLock);
+    version = customGraphVersion;
+    return customGraph;
 }
 
-GranularProcessor& SignalPathManager::getGranularFromChain()
+void SignalPathManager::setWetOnly(uint32_t mask, uint32_t wetOnlyMask)
 {
-    return getProcessorFromChain<GranularProcessor, granular>();
+    // TODO: PROCESSOR_ADDITION_CHAIN(30): add the new processor here if it
+    //       has a wet/dry mix
+    if ((mask & (1u << delay)) != 0)
+        delayProcessor.setWetOnly((wetOnlyMask & (1u << delay)) != 0);
+    if ((mask & (1u << granular)) != 0)
+        granularProcessor.setWetOnly((wetOnlyMask & (1u << granular)) != 0);
+    if ((mask & (1u << reverb)) != 0)
+        reverbProcessor.setWetOnly((wetOnlyMask & (1u << reverb)) != 0);
 }
 
-LooperProcessor& SignalPathManager::getLooperFromChain()
+bool SignalPathManager::areReady(uint32_t mask) const noexcept
 {
-    return getProcessorFromChain<LooperProcessor, looper>();
+    for (int index = 0; index < numProcessors; ++index)
+        if ((mask & (1u << index)) != 0 && resourceStates[static_cast<size_t>(index)].load() != ready)
+            return false;
+    return true;
+}
+
+void SignalPathManager::applyPendingPath() noexcept
+{
+    // the last plan we swapped out has to be collected before we can retire
+    // another one
+    if (retiredPath.load() != nullptr)
+        return;
+
+    // the outgoing plan of a finished transition goes first
+    if (outgoingPath != nullptr && !transition.isActive())
+    {
+        retiredPath = outgoingPath.release();
+        outgoingProcessors = 0;
+        processorsInUse = activeProcessors;
+        return;
+    }
+
+    // take the newest plan, retiring one that's still waiting (the next
+    // block can swap in once that's been collected)
+    if (auto* published = pendingPath.exchange(nullptr))
+    {
+        if (waitingPath != nullptr)
+        {
+            retiredPath = waitingPath.release();
+            waitingPath.reset(published);
+            return;
+        }
+
+        waitingPath.reset(published);
+    }
+
+    if (waitingPath == nullptr)
+        return;
+
+    // one transition at a time, cut the current one's tail short. A duck is
+    // the first half of switching to the waiting plan, so it carries on
+    if (transition.isActive() && !transition.isDucking())
+    {
+        transition.requestRelease();
+        return;
+    }
+
+    // claim the new processors before checking them, see processorsInUse
+    const auto needed = waitingPath->plan.getProcessorMask();
+    processorsInUse = activeProcessors | needed;
+
+    // a processor both plans use has one state, so it can't run in both for
+    // a crossfade. When they share one and the graph changes (the topology
+    // or a wet-only setting), the output is ducked out, the plans switched in
+    // the silence, and the output faded back in. Once a duck has started it
+    // finishes, even if the plan waiting by then needs none
+    const auto isSameGraph = waitingPath->plan.getGraph() == activePath->plan.getGraph();
+    const auto needsDuck = transition.isEnabled() && !isSameGraph && (activeProcessors & needed) != 0;
+
+    if (areReady(needed) && needsDuck && !transition.isDucking())
+        transition.startDuck();
+
+    if (areReady(needed) && (!transition.isDucking() || transition.isDucked()))
+    {
+        // processors kept warm from an earlier graph may have missed a reset,
+        // and the ones with a tail still hold audio from before they left
+        const auto switchedIn = needed & ~activeProcessors;
+        const auto toReset = switchedIn & (staleProcessors | tailProcessors);
+        for (int index = 0; index < numProcessors; ++index)
+            if ((toReset & (1u << index)) != 0)
+                withProcessor(static_cast<ProcessorIndex>(index), [](auto& processor) { processor.reset(); });
+        staleProcessors &= ~switchedIn;
+
+        setWetOnly(needed, waitingPath->plan.getWetOnlyMask());
+
+        // keep the old plan running while the processors that leave ring out.
+        // With no processor in common the two are crossfaded, after a duck
+        // the new plan fades in
+        const auto leaving = activeProcessors & ~needed;
+        if (transition.isDucking())
+        {
+            if (leaving != 0)
+            {
+                outgoingPath = std::move(activePath);
+                outgoingProcessors = leaving;
+            }
+            else
+                retiredPath = activePath.release();
+
+            transition.start(PathTransition::fadeIn, leaving != 0);
+        }
+        else if (transition.isEnabled() && !isSameGraph)
+        {
+            outgoingPath = std::move(activePath);
+            outgoingProcessors = leaving;
+            transition.start(PathTransition::crossfade);
+        }
+        else
+            retiredPath = activePath.release();
+
+        activePath = std::move(waitingPath);
+        activeProcessors = needed;
+        currentMode = activePath->mode;
+        tailLengthChanged = true;
+
+        // the processors that just switched in get the settings held back
+        // while they were inactive before their first block
+        pushParameterGroups();
+    }
+
+    processorsInUse = activeProcessors | outgoingProcessors;
+}
+
+void SignalPathManager::updateResources()
+{
+    // free the plan the audio thread swapped out
+    delete retiredPath.exchange(nullptr);
+
+    ProcessingMode mode;
+    uint32_t version;
+    const auto graph = getRequestedGraph(mode, version);
+    const auto needed = graph.getProcessorMask();
+    const auto now = juce::Time::getMillisecondCounter();
+
+    for (int index = 0; index < numProcessors; ++index)
+    {
+        const auto bit = 1u << index;
+        auto& state = resourceStates[static_cast<size_t>(index)];
+
+        if ((needed & bit) != 0)
+        {
+            lastNeededTimes[static_cast<size_t>(index)] = now;
+
+            // the audio thread won't touch a processor until it's ready
+            int expected = released;
+            if (state.compare_exchange_strong(expected, preparing))
+            {
+                withProcessor(static_cast<ProcessorIndex>(index), [this](auto& processor) { processor.prepare(currentSpec); });
+                state = ready;
+            }
+        }
+        else if (now - lastNeededTimes[static_cast<size_t>(index)] > releaseAfterMs)
+        {
+            int expected = ready;
+            if (!state.compare_exchange_strong(expected, releasing))
+                continue;
+
+            // the audio thread may have claimed it in the meantime, and the
+            // looper's memory is the user's recording, which stays until
+            // they clear it
+            if ((processorsInUse.load() & bit) != 0 || (index == looper && looperProcessor.hasLoop()))
+            {
+                state = ready;
+                continue;
+            }
+
+            withProcessor(static_cast<ProcessorIndex>(index), [](auto& processor) { processor.releaseResources(); });
+            state = released;
+        }
+    }
+
+    // compile and publish the requested graph once, the audio thread picks
+    // it up at the next block (wait until it's taken the previous one)
+    const auto isNewRequest = static_cast<int>(mode) != publishedMode
+                           || (mode == Custom && version != publishedGraphVersion);
+
+    if (isNewRequest && pendingPath.load() == nullptr)
+    {
+        pendingPath = new CompiledPath(mode, graph, currentSpec);
+        publishedMode = mode;
+        publishedGraphVersion = version;
+    }
+}
+
+void SignalPathManager::clearPaths()
+{
+    activePath.reset();
+    outgoingPath.reset();
+    waitingPath.reset();
+    delete pendingPath.exchange(nullptr);
+    delete retiredPath.exchange(nullptr);
 }
 
 // TODO: PROCESSOR_ADDITION_CHAIN(20): add new *direct* processor getters here
 DelayProcessor* SignalPathManager::getDelayProcessor()
 {
-    if (processorChain && processorActiveStates[delay])
-        return &getDelayFromChain();
-    return nullptr;
+    return (activeProcessors & (1u << delay)) != 0 ? &delayProcessor : nullptr;
 }
 
 ReverbProcessor* SignalPathManager::getReverbProcessor()
 {
-    if (processorChain && processorActiveStates[reverb])
-        return &getReverbFromChain();
-    return nullptr;
+    return (activeProcessors & (1u << reverb)) != 0 ? &reverbProcessor : nullptr;
 }
 
 GranularProcessor* SignalPathManager::getGranularProcessor()
 {
-    if (processorChain && processorActiveStates[granular])
-        return &getGranularFromChain();
-    return nullptr;
+    return (activeProcessors & (1u << granular)) != 0 ? &granularProcessor : nullptr;
 }
 
 LooperProcessor* SignalPathManager::getLooperProcessor()
 {
-    if (processorChain && processorActiveStates[looper])
-        return &getLooperFromChain();
-    return nullptr;
+    return (activeProcessors & (1u << looper)) != 0 ? &looperProcessor : nullptr;
 }
 
-
-void SignalPathManager::initializeProcessorChain()
+void SignalPathManager::initializeProcessors()
 {
     jassert(currentSpec.sampleRate >= 0); // Ensure the sample rate is valid
     if (currentSpec.sampleRate <= 0)
         return; // Exit if the sample rate is invalid
 
-    // initialize the entire processorChain
-    if (processorChain)
-        processorChain->prepare(currentSpec);
+    clearPaths();
 
-    // TODO: PROCESSOR_ADDITION_CHAIN(12): add the processor to the initialization logic
-}
+    // prepare what the requested graph reaches and release the rest, which
+    // never acquire their buffers unless a graph that needs them is requested
+    ProcessingMode mode;
+    uint32_t version;
+    const auto graph = getRequestedGraph(mode, version);
+    const auto needed = graph.getProcessorMask();
+    const auto now = juce::Time::getMillisecondCounter();
 
-void SignalPathManager::updateActiveProcessors()
-{
-    // TODO: PROCESSOR_ADDITION_CHAIN(22): set up a new processor active flag,
-    //       and add it to the switch statement below + default to false
+    for (int index = 0; index < numProcessors; ++index)
+    {
+        const auto isNeeded = (needed & (1u << index)) != 0;
+        const auto processorIndex = static_cast<ProcessorIndex>(index);
+
+        if (isNeeded)
+            withProcessor(processorIndex, [this](auto& processor) { processor.prepare(currentSpec); });
+        else
+            withProcessor(processorIndex, [](auto& processor) { processor.releaseResources(); });
 
-    // reset all processor states to inactive
-    for (auto& [processor, active] : processorActiveStates) {
-        active = false;
+        resourceStates[static_cast<size_t>(index)] = isNeeded ? ready : released;
+        lastNeededTimes[static_cast<size_t>(index)] = now;
     }
 
-    // set active flags based on current mode
-    switch (currentMode)
-    {
-        case DelayOnly:
-            processorActiveStates[delay] = true;
-            break;
+    activePath = std::make_unique<CompiledPath>(mode, graph, currentSpec);
+    setWetOnly(needed, activePath->plan.getWetOnlyMask());
+    activeProcessors = needed;
+    currentMode = mode;
+    publishedMode = mode;
+    publishedGraphVersion = version;
+
+    processorsInUse = needed;
+    outgoingProcessors = 0;
+    staleProcessors = 0;
+
+    // nothing's processing yet, so we can work the tail out here for a host
+    // that asks before the first block
+    tailLengthChanged = true;
+    updateTailLength();
+}
 
-        case ReverbOnly:
-            processorActiveStates[reverb] = true;
-            break;
+void SignalPathManager::bindParameters(const juce::AudioProcessorValueTreeState& apvts)
+{
+    parameterBindings.bind(apvts);
+}
 
-        case GranularOnly:
-            processorActiveStates[granular] = true;
-            break;
+void SignalPathManager::updateProcessorChainParameters()
+{
+    // collect the groups that changed since the last block, keeping any that
+    // couldn't be pushed earlier because their processor was inactive
+    pendingParameterGroups |= parameterBindings.update();
+    pushParameterGroups();
+}
 
-        case LooperOnly:
-            processorActiveStates[looper] = true;
-            break;
+void SignalPathManager::pushParameterGroups() noexcept
+{
+    if (pendingParameterGroups == 0)
+        return;
 
-        case Serial:
-            // all processors are active in serial mode, except for the standard
-            // delay, because it's not necessary with the granular delay
-            // processor
-            // TODO: PROCESSOR_ADDITION_CHAIN(24): add new processor active flags here
-            processorActiveStates[looper] = true;
-            processorActiveStates[delay] = false;
-            processorActiveStates[granular] = true;
-            processorActiveStates[reverb] = true;
-            break;
+    // a group stays pending while its processor is inactive, so only one
+    // that's actually pushed can change the tail
+    const auto pendingBefore = pendingParameterGroups;
 
-        default:
-            // use DelayOnly as a fallback
-            processorActiveStates[delay] = true;
-            jassertfalse; // unexpected mode, should never happen
-            break;
+    if ((pendingParameterGroups & ParameterBindings::delayGroup) != 0)
+    {
+        if (auto* delay = getDelayProcessor())
+        {
+            delay->updateParameters(parameterBindings.getDelayParams());
+            pendingParameterGroups &= ~static_cast<uint32_t>(ParameterBindings::delayGroup);
+        }
     }
+    if ((pendingParameterGroups & ParameterBindings::reverbGroup) != 0)
+    {
+        if (auto* reverb = getReverbProcessor())
+        {
+            reverb->updateParameters(parameterBindings.getReverbParams());
+            pendingParameterGroups &= ~static_cast<uint32_t>(ParameterBindings::reverbGroup);
+        }
+    }
+    if ((pendingParameterGroups & ParameterBindings::granularGroup) != 0)
+    {
+        if (auto* granular = getGranularProcessor())
+        {
+            granular->updateParameters(parameterBindings.getGranularParams());
+            pendingParameterGroups &= ~static_cast<uint32_t>(ParameterBindings::granularGroup);
+        }
+    }
+    // TODO: PROCESSOR_ADDITION_CHAIN(?): Add similar blocks for other processor parameters here
 
-    // TODO: PROCESSOR_ADDITION_CHAIN(15): add new processor active flags here
+    if (pendingParameterGroups != pendingBefore)
+        tailLengthChanged = true;
 }
 
-void SignalPathManager::updateProcessorChainParameters(const juce::AudioProcessorValueTreeState& apvts)
+void SignalPathManager::updateTailLength() noexcept
 {
-    if (auto* delay = getDelayProcessor()) {
-        DelayProcessor::DelayParams params;
-        if (auto* v = apvts.getRawParameterValue("delayTime")) params.delayTime = *v;
-        if (auto* v = apvts.getRawParameterValue("feedback")) params.feedback = *v;
-        if (auto* v = apvts.getRawParameterValue("wetDry")) params.wetLevel = *v;
-        delay->updateParameters(params);
+    // the looper can also move on by itself (a full recording starts playing)
+    if (auto* looper = getLooperProcessor(); looper != nullptr && looper->getState() != tailLooperState)
+    {
+        tailLooperState = looper->getState();
+        tailLengthChanged = true;
     }
-    if (auto* reverb = getReverbProcessor()) {
-        ReverbProcessor::ReverbParams params;
-        if (auto* v = apvts.getRawParameterValue("reverbRoomSize")) params.roomSize = *v;
-        if (auto* v = apvts.getRawParameterValue("reverbDamping")) params.damping = *v;
-        if (auto* v = apvts.getRawParameterValue("reverbMix")) {
-            params.wetLevel = *v;
-            params.dryLevel = 1.0f - *v;
+
+    if (!tailLengthChanged)
+        return;
+
+    tailLengthChanged = false;
+
+    // TODO: PROCESSOR_ADDITION_CHAIN(33): give the new processor a
+    //       getTailLengthSeconds, worked out from its own settings
+    // tails add up along a branch and through the stages, the branches of a
+    // stage ring out side by side so only the longest counts
+    double tail = 0.0;
+    for (const auto& stage : activePath->plan.getGraph().stages)
+    {
+        double stageTail = 0.0;
+        for (const auto& branch : stage)
+        {
+            double branchTail = 0.0;
+            for (const auto index : branch.processors)
+                withProcessor(static_cast<ProcessorIndex>(index), [&branchTail](auto& processor) { branchTail += processor.getTailLengthSeconds(); });
+
+            stageTail = juce::jmax(stageTail, branchTail);
         }
-        if (auto* v = apvts.getRawParameterValue("reverbWidth")) params.width = *v;
-        if (auto* v = apvts.getRawParameterValue("reverbFreeze")) params.freezeMode = *v;
-        reverb->updateParameters(params);
-    }
-    if (auto* granular = getGranularProcessor()) {
-        GranularProcessor::GranularParams params;
-        if (auto* v = apvts.getRawParameterValue("granularDelayTime")) params.delayTime = *v;
-        if (auto* v = apvts.getRawParameterValue("grainSize")) params.grainSize = *v;
-        if (auto* v = apvts.getRawParameterValue("grainDensity")) params.grainDensity = *v;
-        if (auto* v = apvts.getRawParameterValue("pitchShift")) params.pitchShift = *v;
-        if (auto* v = apvts.getRawParameterValue("granularFeedback")) params.feedback = *v;
-        if (auto* v = apvts.getRawParameterValue("granularWetDry")) params.wetDryMix = *v;
-        if (auto* v = apvts.getRawParameterValue("spread")) params.spread = *v;
-        granular->updateParameters(params);
-    }
-    if (auto* looper = getLooperProcessor()) {
-        LooperProcessor::LooperParams params;
-        // read the looperState parameter
-        if (auto* v = apvts.getRawParameterValue("looperState"))
-            params.looperState = static_cast<int>(*v);
-        looper->updateParameters(params);
+
+        tail += stageTail;
     }
-    // TODO: PROCESSOR_ADDITION_CHAIN(?): Add similar blocks for other processor parameters here
-}
 
+    // an endless tail (a playing loop) is already the longest we report
+    tailLengthSeconds = juce::jmin(tail, SilenceDetector::longestTailSeconds);
+}
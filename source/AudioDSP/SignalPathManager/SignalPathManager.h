@@ -6,11 +6,17 @@
 * @file SignalPathManager.cpp
 * @brief Class to manage how the signal travels through the audio processing chain
 *
-* By default, the signal path is set up as a serial chain of processors,
-* with different processing modes made available by bypassing all other processors
+* Each processing mode (or a custom graph from setGraph) is a ProcessingGraph,
+* compiled into an ExecutionPlan off the audio thread and swapped in once the
+* processors it needs have been prepared by a background thread, which also
+* releases the ones no graph uses any more. Graph changes crossfade or duck
+* (PathTransition.h), every processor's output goes through a SignalGuard,
+* and the result through an OutputLimiter. Processors skip their blocks while
+* they're silent (SilenceDetector.h).
 *
 * @description
 * currentMode: The current processing mode, determines which processors are active in the chain
+* requestedMode: The mode the audio thread switches to once its processors are ready
 */
 
 #pragma once
@@ -20,12 +26,21 @@
 
 #include <juce_dsp/juce_dsp.h>
 #include <juce_audio_processors/juce_audio_processors.h>
+#include <array>
+#include <atomic>
+#include <memory>
 
 // include processor headers here
 #include "../Granular-Delay/GranularProcessor.h"
 #include "../Reverb/ReverbProcessor.h"
 #include "../Standard-Delay/DelayProcessor.h"
 #include "../Looper/LooperProcessor.h"
+#include "ParameterBindings.h"
+#include "ExecutionPlan.h"
+#include "PathTransition.h"
+#include "OutputLimiter.h"
+#include "../DSPHelpers/SignalGuard/SignalGuard.h"
+#include "../DSPHelpers/CommandQueue/CommandQueue.h"
 
 // add #include directives above for additional processors as we add them
 
@@ -36,10 +51,83 @@ public:
     SignalPathManager();
     ~SignalPathManager() override;
 
+    // widest layout prepare accepts (third order ambisonics, 7.1.4 is 12)
+    static constexpr int maxChannels = 16;
+
     void prepare(const juce::dsp::ProcessSpec& spec) override;
     void reset() override;
     void process(const juce::dsp::ProcessContextReplacing<float>& context) override;
 
+    // something that happens at a sample within the next block
+    struct TimedEvent
+    {
+        enum Type
+        {
+            parameterValue, // parameter is a ParameterBindings::findParameter index
+            looperState     // value is a LooperProcessor::State
+        };
+
+        Type type = parameterValue;
+        int sampleOffset = 0;
+        int parameter = -1;
+        float value = 0.0f;
+    };
+
+    // shortest sub-block processWithEvents splits a block into
+    static constexpr int minSubBlockSamples = 32;
+
+    // process the block in sub-blocks that start at the events (sorted by
+    // sampleOffset), so each one takes effect at its own sample, give or take
+    // minSubBlockSamples (real-time safe)
+    void processWithEvents(const juce::dsp::ProcessContextReplacing<float>& context,
+                           const TimedEvent* events, int numEvents);
+
+    // free every processor's buffers until the next prepare (message thread,
+    // with the audio stopped)
+    void releaseResources();
+
+    // how long the output can keep going after the input stops: the tails of
+    // the processors in the current graph, added along serial runs and the
+    // longest of parallel branches, capped at
+    // SilenceDetector::longestTailSeconds (any thread, kept up to date by the
+    // audio thread)
+    [[nodiscard]] double getTailLengthSeconds() const noexcept { return tailLengthSeconds.load(); }
+
+    // how late the output limiter makes the output, valid after prepare
+    [[nodiscard]] int getLatencySamples() const noexcept { return outputLimiter.getLatencySamples(); }
+
+    // how many times a processor has been reset by its guard since prepare
+    // (any thread)
+    [[nodiscard]] int getNumGuardTrips() const noexcept { return numGuardTrips.load(); }
+
+    // how many samples the looper and delay have lost since they were
+    // prepared because their memory pools ran dry (any thread)
+    [[nodiscard]] juce::int64 getNumDroppedSamples() const noexcept
+    {
+        return looperProcessor.getNumDroppedSamples() + delayProcessor.getNumDroppedSamples();
+    }
+
+    // set how many worker threads help render parallel branches, 0 renders
+    // everything on the audio thread. Takes effect on the next prepare()
+    void setNumWorkerThreads(int newNumWorkerThreads);
+    [[nodiscard]] int getNumWorkerThreads() const noexcept { return numWorkerThreads; }
+
+    // set how many grains the granular delay can play at once. Takes effect
+    // on the next prepare()
+    void setMaxGrains(int newMaxGrains);
+    [[nodiscard]] int getMaxGrains() const noexcept { return maxGrains; }
+
+    // set the speaker or ambisonic layout of the channels, which the reverb
+    // and the grain scatter lay themselves out by. Takes effect on the next
+    // prepare()
+    void setChannelLayout(const juce::AudioChannelSet& newLayout);
+
+    // set the crossfade time for graph changes, 0 switches without a
+    // transition and cuts off the tails. Takes effect on the next prepare()
+    void setTransitionTime(double newTransitionSeconds);
+    [[nodiscard]] double getTransitionTime() const noexcept { return transitionSeconds; }
+    static constexpr double defaultTransitionSeconds = 0.05;
+
     // processing mode enum
     enum ProcessingMode
     {
@@ -47,105 +135,303 @@ public:
         ReverbOnly = 1,
         GranularOnly = 2,
         LooperOnly = 3,
-        Serial = 4
+        Serial = 4,
+        Parallel = 5,
+        SendReturn = 6,
         // TODO: PROCESSOR_ADDITION_CHAIN(9): add a new processing mode for the
         //       new processor here
+        Custom = 7 // the graph passed to setGraph, not a signalPath choice
     };
 
-    // set the processing mode (this will initialize the necessary chains)
+    // processor indices, used to build a ProcessingGraph
+    enum ProcessorIndex
+    {
+        looper,
+        delay,
+        granular,
+        reverb,
+        // TODO: PROCESSOR_ADDITION_CHAIN(10): add a new index for the new
+        //       processor here
+        numProcessors
+    };
+
+    // request a processing mode (safe from any thread, doesn't block). The
+    // audio thread switches once every processor the mode needs is prepared
     void setProcessingMode(ProcessingMode newMode);
 
-    // get the current processing mode
+    // request a custom graph, which stays in use until the next
+    // setProcessingMode (message thread). Returns false if the graph uses a
+    // processor more than once, one that doesn't exist, or sends to one that
+    // can't render wet only
+    bool setGraph(const ProcessingGraph& newGraph);
+
+    // the preset graph for a processing mode
+    [[nodiscard]] static ProcessingGraph getGraphForMode(ProcessingMode mode);
+
+    // get the mode the audio thread is currently processing
     [[nodiscard]] ProcessingMode getCurrentMode() const { return currentMode; }
 
-    // get processor references for parameter updates
-    // this is more efficient than having separate parameter update methods
+    // queue a looper transport command (LooperProcessor::State), safe from
+    // any thread. It's applied at the start of the next block, or once the
+    // looper is back in the graph. Returns false if the queue is full
+    bool setLooperState(int newState);
+
+    // get processor references for parameter updates, nullptr if the
+    // processor isn't in the current graph (audio thread)
     DelayProcessor* getDelayProcessor();
     ReverbProcessor* getReverbProcessor();
     GranularProcessor* getGranularProcessor();
     LooperProcessor* getLooperProcessor();
 
-    // template getter for processors in the main chain
-    template<typename ProcessorType, int Index>
-    ProcessorType& getProcessorFromChain()
-    {
-        jassert(processorChain != nullptr);
-        return processorChain->template get<Index>();
-    }
+    // resolve the parameter pointers used by updateProcessorChainParameters,
+    // call once from the message thread before processing starts
+    void bindParameters (const juce::AudioProcessorValueTreeState& apvts);
 
-    // update processor chain parameters based on the current mode
-    void updateProcessorChainParameters (const juce::AudioProcessorValueTreeState& apvts);
+    // push changed parameters to the active processors (real-time safe, no
+    // string lookups, only processors whose values changed are updated)
+    void updateProcessorChainParameters();
 
 private:
-    // define processor chain index constants
-    enum ProcessorIndex
+    //=processors===============================================================
+    // TODO: PROCESSOR_ADDITION_CHAIN(11): add the new processor here, and to
+    //       the processors array in the constructor
+    LooperProcessor looperProcessor;
+    DelayProcessor delayProcessor;
+    GranularProcessor granularProcessor;
+    ReverbProcessor reverbProcessor;
+
+    // the same processors by ProcessorIndex, which is what plans index
+    std::array<juce::dsp::ProcessorBase*, numProcessors> processors {};
+
+    // processors that can render wet only, and so can be used on a send
+    // TODO: PROCESSOR_ADDITION_CHAIN(28): add the new processor here if it
+    //       has a wet/dry mix, and to setWetOnly
+    static constexpr uint32_t wetOnlyProcessors = (1u << delay) | (1u << granular) | (1u << reverb);
+
+    // processors whose state is the user's content (the looper's recording),
+    // which a guard trip mustn't reset, it only drops their block
+    // TODO: PROCESSOR_ADDITION_CHAIN(34): add the new processor here if it
+    //       records or stores something the user made
+    static constexpr uint32_t keepStateProcessors = 1u << looper;
+
+    // switch the processors in mask to the wet only rendering the plan asks for
+    void setWetOnly(uint32_t mask, uint32_t wetOnlyMask);
+
+    // call function with the processor at index
+    template <typename Function>
+    void withProcessor(ProcessorIndex index, Function&& function)
     {
-        looper,
-        delay,
-        granular,
-        reverb
-        // TODO: PROCESSOR_ADDITION_CHAIN(10): add a new index for the new
-        //       processor here
+        // TODO: PROCESSOR_ADDITION_CHAIN(21): add the new processor here
+        switch (index)
+        {
+            case looper:   function(looperProcessor);   break;
+            case delay:    function(delayProcessor);    break;
+            case granular: function(granularProcessor); break;
+            case reverb:   function(reverbProcessor);   break;
+            case numProcessors:
+            default:       jassertfalse;                break;
+        }
+    }
+
+    //=plans====================================================================
+    // a compiled graph, and the mode it was built for
+    struct CompiledPath
+    {
+        CompiledPath(ProcessingMode modeToUse, const ProcessingGraph& graph, const juce::dsp::ProcessSpec& spec)
+            : mode(modeToUse), plan(graph, spec, keepStateProcessors) {}
+
+        ProcessingMode mode;
+        ExecutionPlan plan;
     };
 
-    // Map of processor indices to their active states
-    // TODO: PROCESSOR_ADDITION_CHAIN(23): add a new flag to set the new processor's active state
-    std::unordered_map<ProcessorIndex, bool> processorActiveStates = {
-        {looper, false},
-        {delay, false},
-        {granular, false},
-        {reverb, false} // this is a placeholder for the serial chain, not a processor
-        // When adding a new processor, add it here too
+    // audio thread: the plan being processed, and a new one waiting for its
+    // processors to be ready
+    std::unique_ptr<CompiledPath> activePath;
+    std::unique_ptr<CompiledPath> waitingPath;
+
+    // warm-up thread -> audio thread: the newest compiled plan
+    std::atomic<CompiledPath*> pendingPath { nullptr };
+
+    // audio thread -> warm-up thread: a plan that's been swapped out, freed
+    // by the warm-up thread (a new plan is only swapped in once it's empty)
+    std::atomic<CompiledPath*> retiredPath { nullptr };
+
+    // bit per processor in the active plan (audio thread)
+    uint32_t activeProcessors = 0;
+
+    // audio thread: the plan being switched away from while its tails decay,
+    // and the processors only it uses (the others have moved to activePath).
+    // It's retired once the transition has finished, and no new plan is
+    // swapped in before then
+    std::unique_ptr<CompiledPath> outgoingPath;
+    uint32_t outgoingProcessors = 0;
+
+    PathTransition transition;
+    double transitionSeconds = defaultTransitionSeconds;
+
+    // processors with a tail, which are reset as they're switched in so
+    // they don't replay whatever they held when they were switched out
+    // TODO: PROCESSOR_ADDITION_CHAIN(31): add the new processor here if it
+    //       holds a delay line or reverb tail
+    static constexpr uint32_t tailProcessors = (1u << delay) | (1u << granular) | (1u << reverb);
+
+    // current processing mode, only changed by the audio thread (or prepare)
+    ProcessingMode currentMode = DelayOnly;
+
+    // latest mode asked for through setProcessingMode (or Custom)
+    std::atomic<int> requestedMode { DelayOnly };
+
+    // latest graph passed to setGraph, guarded by customGraphLock (never taken
+    // on the audio thread)
+    ProcessingGraph customGraph;
+    uint32_t customGraphVersion = 0;
+    juce::CriticalSection customGraphLock;
+
+    // the requested graph for the current request, and a key for it
+    ProcessingGraph getRequestedGraph(ProcessingMode& mode, uint32_t& version);
+
+    // warm-up thread only: the request the last plan was compiled for
+    int publishedMode = -1;
+    uint32_t publishedGraphVersion = 0;
+
+    //=resource management======================================================
+    // each processor's buffers go released -> preparing -> ready on the
+    // warm-up thread, and ready -> releasing -> released once no graph has
+    // needed them for releaseAfterMs. The looper is kept while it holds a
+    // loop, releasing it would delete the recording
+    enum ResourceState
+    {
+        released,
+        preparing,
+        ready,
+        releasing
     };
 
-    // Helper function to set processor bypass states
-    template<typename ChainType>
-    void setProcessorBypassStates(ChainType& chain)
+    std::array<std::atomic<int>, numProcessors> resourceStates {};
+
+    // bit per processor the audio thread may process. It's set before the
+    // audio thread checks a processor is ready, and the warm-up thread checks
+    // it after claiming a processor for release, so the two can't both win
+    std::atomic<uint32_t> processorsInUse { 0 };
+
+    // processors that missed a reset() while they weren't in use, they're
+    // reset when they're next switched in
+    uint32_t staleProcessors = 0;
+
+    // warm-up thread only: when each processor was last needed
+    std::array<juce::uint32, numProcessors> lastNeededTimes {};
+
+    static constexpr juce::uint32 releaseAfterMs = 10000;
+    static constexpr int warmUpPeriodMs = 20;
+    static constexpr int warmUpStopTimeoutMs = 2000;
+
+    [[nodiscard]] bool areReady(uint32_t mask) const noexcept;
+
+    // audio thread: swap in a new plan once its processors are ready
+    void applyPendingPath() noexcept;
+
+    // warm-up thread: prepare what the requested graph needs, publish its
+    // plan, and release what hasn't been needed for a while
+    void updateResources();
+
+    // free any plans in flight between the threads (warm-up thread stopped)
+    void clearPaths();
+
+    // background thread that runs updateResources every warmUpPeriodMs
+    class WarmUpThread : public juce::Thread
     {
-        // Template specializations to handle each processor type
-        if constexpr (std::is_same_v<ChainType, MainChainType>) {
-            // TODO: PROCESSOR_ADDITION_CHAIN(21): add a new bypass handler for the
-            //       new processor here
-            chain.setBypassed<looper>(!processorActiveStates[looper]);
-            chain.setBypassed<delay>(!processorActiveStates[delay]);
-            chain.setBypassed<granular>(!processorActiveStates[granular]);
-            chain.setBypassed<reverb>(!processorActiveStates[reverb]);
+    public:
+        explicit WarmUpThread(SignalPathManager& managerToUse)
+            : juce::Thread("Signal path warm-up"), manager(managerToUse) {}
+
+        void run() override
+        {
+            while (!threadShouldExit())
+            {
+                manager.updateResources();
+                wait(warmUpPeriodMs);
+            }
         }
-    }
 
-    // current processing mode
-    ProcessingMode currentMode = DelayOnly;
+    private:
+        SignalPathManager& manager;
+    };
 
-    // process spec for initializing processors
-    juce::dsp::ProcessSpec currentSpec;
+    //=commands=================================================================
+    // events queued from other threads, applied in order by the audio thread
+    // at the start of a block
+    struct Command
+    {
+        enum Type
+        {
+            looperState
+        };
+
+        Type type = looperState;
+        int value = 0;
+    };
+
+    static constexpr size_t commandQueueSize = 256;
+    CommandQueue<Command, commandQueueSize> commands;
+
+    // the latest looper command that arrived while the looper wasn't in the
+    // graph, applied once it's switched back in (-1 for none)
+    int pendingLooperState = -1;
 
-    // Serial chain type definition (used for all chains)
-    using MainChainType = juce::dsp::ProcessorChain<
-        LooperProcessor,
-        DelayProcessor,
-        GranularProcessor,
-        ReverbProcessor>;
+    // audio thread: apply the queued commands
+    void applyCommands() noexcept;
 
-    // TODO: PROCESSOR_ADDITION_CHAIN(11): add new processor chain pointers here
-    //       + add a flag for it to track whether or not it's enabled
+    // audio thread: apply an event at the start of its sub-block
+    void applyEvent(const TimedEvent& event) noexcept;
 
-    // single processor chain instance
-    std::unique_ptr<MainChainType> processorChain;
+    // parameter snapshot, plus the groups that changed but haven't been pushed
+    // yet because their processor wasn't active
+    ParameterBindings parameterBindings;
+    uint32_t pendingParameterGroups = 0;
 
-    // Initialize and configure the processor chain for the current mode
-    void initializeProcessorChain();
+    // push the pending groups to the processors that are active
+    void pushParameterGroups() noexcept;
 
-    // Helper methods to get processor references from the main chain
-    DelayProcessor& getDelayFromChain();
-    ReverbProcessor& getReverbFromChain();
-    GranularProcessor& getGranularFromChain();
-    LooperProcessor& getLooperFromChain();
+    // the current graph's tail for getTailLengthSeconds, worked out again
+    // after the graph, a parameter or the looper's state changes
+    std::atomic<double> tailLengthSeconds { 0.0 };
+    bool tailLengthChanged = true;
+    int tailLooperState = -1;
 
-    // Configure which processors are active in the current chain
-    void updateActiveProcessors();
+    // audio thread: recompute the tail if anything it depends on has changed
+    void updateTailLength() noexcept;
+
+    //=output safety============================================================
+    // last stage of every block, after the graph and any transition
+    OutputLimiter outputLimiter;
+
+    // the block scan the input guard uses, picked in prepare
+    const KernelDispatch::Kernels* kernels = &KernelDispatch::getKernels(KernelDispatch::Generic);
+
+    // processors reset by the plans' guards
+    std::atomic<int> numGuardTrips { 0 };
+
+    // audio thread: count the processors the plans' guards have reset
+    void collectGuardTrips() noexcept;
+
+    // process spec for initializing processors
+    juce::dsp::ProcessSpec currentSpec;
+    juce::AudioChannelSet channelLayout;
+    int maxGrains = granularProcessor.getMaxGrains();
+
+    // workers for parallel branches, started in prepare and stopped in
+    // releaseResources, so an idle plugin holds no threads
+    int numWorkerThreads = 0;
+    std::unique_ptr<RealtimeWorkerPool> workerPool;
+
+    // declared last, and stopped in the destructor before anything else goes
+    WarmUpThread warmUpThread { *this };
+
+    // prepare the processors the current mode reaches and release the rest,
+    // then compile its plan
+    void initializeProcessors();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SignalPathManager)
 };
 
 #endif //SIGNALPATHMANAGER_H
-
@@ -17,30 +17,50 @@ DelayProcessor::~DelayProcessor()
 void DelayProcessor::prepare(const juce::dsp::ProcessSpec& spec)
 {
     // calculate the maximum delay in samples for 60 seconds
-    const int maxDelaySamples = static_cast<int>(spec.sampleRate * 60.0);
+    const int maxDelaySamples = static_cast<int>(spec.sampleRate * maxDelaySeconds);
 
-    // prepare the left DelayLine with the sampleRate and maximum delay time
-    leftDelay.prepare(spec);
-    leftDelay.setMaximumDelayInSamples(maxDelaySamples);
-    leftDelay.reset();
+    // size the delay memory (plus room for the interpolation neighbour), one
+    // line per channel, only the chunk table is allocated here, audio memory
+    // is committed as it's used
+    delayStore.prepare(static_cast<int>(spec.numChannels), maxDelaySamples + 2, ChunkedAudioStore::defaultChunkSize,
+                       ChunkedAudioStore::getReserveChunks(spec.sampleRate, static_cast<int>(spec.maximumBlockSize)));
 
-    // prepare the right DelayLine with the sampleRate and maximum delay time
-    rightDelay.prepare(spec);
-    rightDelay.setMaximumDelayInSamples(maxDelaySamples);
-    rightDelay.reset();
+    // the line starts out empty
+    silenceDetector.reset();
 
     // store sample rate for delay time calculations
     currentSampleRate = spec.sampleRate;
+    maxBlockSize = static_cast<int>(spec.maximumBlockSize);
 
-    // update delay time based on current sample rate
+    // prepare the parameter smoothers for the new block size
+    delayTimeSmoother.prepare(spec.sampleRate, maxBlockSize, delayTimeRampSeconds);
+    feedbackSmoother.prepare(spec.sampleRate, maxBlockSize, gainRampSeconds);
+    wetLevelSmoother.prepare(spec.sampleRate, maxBlockSize, gainRampSeconds);
+
+    // update delay time based on current sample rate, with no ramp from the
+    // previous values
     updateParameters(delayParams);
+    delayTimeSmoother.setCurrentAndTargetValue(delayTimeSmoother.getTargetValue());
+    feedbackSmoother.setCurrentAndTargetValue(feedbackSmoother.getTargetValue());
+    wetLevelSmoother.setCurrentAndTargetValue(wetLevelSmoother.getTargetValue());
 }
 
 void DelayProcessor::reset()
 {
-    // make sure the channels are both empty
-    leftDelay.reset();
-    rightDelay.reset();
+    // make sure the channels are both empty, handing every chunk back to the
+    // pool (no zeroing or freeing happens on this thread)
+    delayStore.releaseAll();
+    writePosition = 0;
+    silenceDetector.reset();
+}
+
+void DelayProcessor::releaseResources()
+{
+    delayStore.release();
+    writePosition = 0;
+
+    // process() refuses to run until we're prepared again
+    maxBlockSize = 0;
 }
 
 void DelayProcessor::process(const juce::dsp::ProcessContextReplacing<float>& context)
@@ -48,54 +68,150 @@ void DelayProcessor::process(const juce::dsp::ProcessContextReplacing<float>& co
     // TODO: PROCESSOR_ADDITION_CHAIN(EXAMPLE): make sure you wrap the processing
     //       in a check to see if the processor is bypassed, as shown below
 
-    if (context.getInputBlock().getNumChannels() != 0)
-    {
-        DBG("Signal has hit the DelayProcessor!");
-    }
     if (!context.isBypassed)
     {
-        DBG("Signal was not bypassed at the delayProcessor");
-        auto& inputBlock = context.getInputBlock();
+        // the smoother buffers are sized in prepare, so we can't run before that
+        jassert(maxBlockSize > 0);
+        if (maxBlockSize <= 0)
+            return;
+
         auto& outputBlock = context.getOutputBlock();
+        const auto numSamples = outputBlock.getNumSamples();
+        const auto chunkSize = static_cast<size_t>(maxBlockSize);
+
+        // skip the block while the input and the echoes are both silent
+        const auto silence = silenceDetector.process(outputBlock,
+            [this](float level) { return getTailSamples(level); });
 
-        // handle mono case by duplicating single channel
-        const auto numChannels = juce::jmin(
-            inputBlock.getNumChannels(),
-            outputBlock.getNumChannels(),
-            static_cast<size_t> (2)
-        );
+        if (silence != SilenceDetector::awake)
+        {
+            // what's left in the line is below the silence level, so hand
+            // its memory back and wake up from empty
+            if (silence == SilenceDetector::fallingAsleep)
+                reset();
+
+            // nothing to ramp while we're asleep, so wake up at the targets
+            delayTimeSmoother.setCurrentAndTargetValue(delayTimeSmoother.getTargetValue());
+            feedbackSmoother.setCurrentAndTargetValue(feedbackSmoother.getTargetValue());
+            wetLevelSmoother.setCurrentAndTargetValue(wetLevelSmoother.getTargetValue());
+
+            // the silent input is already the dry signal, and a send renders nothing
+            if (wetOnly)
+                outputBlock.clear();
+            return;
+        }
+
+        // pick the kernel for the channel count once per block, so the mono
+        // and stereo loops have no channel checks, wider layouts use the
+        // general one (the delay memory has a line for each prepared channel)
+        const auto numChannels = juce::jmin(outputBlock.getNumChannels(),
+            static_cast<size_t>(delayStore.getNumChannels()));
 
-        // process samples using our current parameter values
-        for (int i = 0; i < static_cast<int>(inputBlock.getNumSamples()); ++i)
+        // process in chunks no larger than the smoother buffers (normally just one)
+        for (size_t start = 0; start < numSamples; start += chunkSize)
         {
-            float inputL = inputBlock.getSample(0, i);
-            float inputR = numChannels > 1 ? inputBlock.getSample(1, i) : inputL;
+            const auto chunk = outputBlock.getSubBlock(start, juce::jmin(chunkSize, numSamples - start));
+
+            if (numChannels == 1)
+                processChunk<1>(chunk);
+            else if (numChannels == 2)
+                processChunk<2>(chunk);
+            else
+                processChunk<anyChannels>(chunk.getSubsetChannelBlock(0, numChannels));
+        }
+    }
+}
+
+template <int numChannels>
+void DelayProcessor::processChunk(const juce::dsp::AudioBlock<float>& block)
+{
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+
+    // fixed at compile time for mono and stereo, so the channel loop unrolls
+    const auto channelCount = numChannels != anyChannels ? numChannels : static_cast<int>(block.getNumChannels());
 
-            // store clean signal temporarily for wet/dry mixing
-            auto cleanL = inputL;
-            auto cleanR = inputR;
+    // fill the per-sample parameter ramps for this chunk
+    const auto* delayTimes = delayTimeSmoother.process(numSamples);
+    const auto* feedbacks = feedbackSmoother.process(numSamples);
+    const auto* wetLevels = wetLevelSmoother.process(numSamples);
 
-            // process through delay lines
-            auto delayedL = leftDelay.popSample(0);
-            auto delayedR = rightDelay.popSample(0);
+    // 0 when a send stage mixes the dry signal itself, so the mix below needs
+    // no branch (delayed * wet + clean * 0 is exactly the wet signal)
+    const auto dryScale = wetOnly ? 0.0f : 1.0f;
 
-            leftDelay.pushSample(0, inputL + (delayedL * delayParams.feedback));
-            rightDelay.pushSample(0, inputR + (delayedR * delayParams.feedback));
+    // keep the delay at least one sample, and short of the buffer length
+    const auto maxDelay = static_cast<float>(delayStore.getCapacity() - 2);
+
+    // commit the chunks this chunk writes to
+    delayStore.ensureMapped(writePosition, numSamples);
+
+    // process samples using the smoothed parameter values
+    for (int i = 0; i < numSamples; ++i)
+    {
+        // read every channel at the same fractional delay, relative to this
+        // sample's write position (kept as integer + fraction, since a float
+        // index loses sub-sample precision in a 60 second buffer)
+        const auto delay = juce::jlimit(1.0f, maxDelay, delayTimes[i]);
+        const auto delayInt = static_cast<int>(delay);
+        const auto frac = delay - static_cast<float>(delayInt);
+        const auto readPosition = writePosition + i - delayInt;
+
+        // a mono delay only touches its own line
+        for (int channel = 0; channel < channelCount; ++channel)
+        {
+            auto* samples = block.getChannelPointer(static_cast<size_t>(channel));
+            const auto clean = samples[i];
+
+            const auto a = delayStore.read(channel, readPosition);
+            const auto b = delayStore.read(channel, readPosition - 1);
+            const auto delayed = a + frac * (b - a);
+
+            delayStore.write(channel, writePosition + i, clean + (delayed * feedbacks[i]));
 
             // mix clean and wet signals
-            outputBlock.setSample(0, i, (delayedL * delayParams.wetLevel) + (cleanL * (1.0f - delayParams.wetLevel)));
-            if (numChannels > 1)
-                outputBlock.setSample(1, i, (delayedR * delayParams.wetLevel) + (cleanR * (1.0f - delayParams.wetLevel)));
+            samples[i] = (delayed * wetLevels[i]) + (clean * dryScale * (1.0f - wetLevels[i]));
         }
-    } else DBG("Signal was bypassed at the DelayProcessor");
+    }
+
+    // written chunks stay committed while we run, a longer delay time reads
+    // back whatever was played that long ago. The memory goes back once the
+    // line has gone silent (reset) or the delay has been out of every graph
+    // for a while (releaseResources)
+    writePosition = delayStore.wrap(writePosition + numSamples);
+}
+
+juce::int64 DelayProcessor::getTailSamples(float level) const noexcept
+{
+    const auto feedback = juce::jmax(feedbackSmoother.getCurrentValue(), feedbackSmoother.getTargetValue());
+    if (feedback >= 1.0f)
+        return SilenceDetector::endlessTail;
+
+    // the line holds at most level / (1 - feedback), and every echo comes a
+    // delay time after the last, feedback times quieter
+    const auto delaySamples = std::ceil(juce::jmax(delayTimeSmoother.getCurrentValue(), delayTimeSmoother.getTargetValue())) + 1.0f;
+    const auto lineLevel = level / (1.0f - juce::jmax(0.0f, feedback));
+
+    if (lineLevel < SilenceDetector::silenceLevel)
+        return 0;
+
+    const auto echoes = SilenceDetector::getDecaySamples(lineLevel, feedback, delaySamples);
+    if (echoes == SilenceDetector::endlessTail)
+        return echoes;
+
+    return static_cast<juce::int64>(delaySamples) + echoes;
+}
+
+double DelayProcessor::getTailLengthSeconds() const noexcept
+{
+    return SilenceDetector::toSeconds(getTailSamples(1.0f), currentSampleRate);
 }
 
 void DelayProcessor::updateParameters(const DelayParams& params)
 {
     delayParams = params;
 
-    // update delay time in samples for both delay lines
-    auto delayInSamples = static_cast<float>(delayParams.delayTime * currentSampleRate);
-    leftDelay.setDelay(delayInSamples);
-    rightDelay.setDelay(delayInSamples);
+    // ramp towards the new values, delay time is smoothed in samples
+    delayTimeSmoother.setTargetValue(static_cast<float>(delayParams.delayTime * currentSampleRate));
+    feedbackSmoother.setTargetValue(juce::jlimit(0.0f, maxFeedback, delayParams.feedback));
+    wetLevelSmoother.setTargetValue(delayParams.wetLevel);
 }
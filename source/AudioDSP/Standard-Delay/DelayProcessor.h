@@ -6,6 +6,9 @@
 
 #include <juce_dsp/juce_dsp.h>
 #include <juce_audio_processors/juce_audio_processors.h>
+#include "../DSPHelpers/ParameterSmoother/ParameterSmoother.h"
+#include "../DSPHelpers/ChunkedAudioStore/ChunkedAudioStore.h"
+#include "../DSPHelpers/SilenceDetector/SilenceDetector.h"
 
 #ifndef DELAYPROCESSOR_H
 #define DELAYPROCESSOR_H
@@ -25,21 +28,69 @@ public:
     void prepare(const juce::dsp::ProcessSpec& spec) override;
     void reset() override;
 
+    // free the delay memory until the next prepare (not from the audio thread)
+    void releaseResources();
+
     // required implementation of ProcessorBase::process
     void process(const juce::dsp::ProcessContextReplacing<float>& context) override;
 
     // Set all parameters at once using a struct of raw types
     void updateParameters(const DelayParams& params);
 
+    // render only the delayed signal, scaled by the wet level, for a send
+    // stage that mixes the dry signal itself (audio thread)
+    void setWetOnly(bool shouldBeWetOnly) noexcept { wetOnly = shouldBeWetOnly; }
+
+    // how long the echoes of full scale input take to die away at the
+    // current settings, the longest tail we report at full feedback (audio
+    // thread)
+    [[nodiscard]] double getTailLengthSeconds() const noexcept;
+
+    // samples lost from the delay line since prepare because its memory
+    // couldn't be committed in time (any thread)
+    [[nodiscard]] juce::int64 getNumDroppedSamples() const noexcept { return delayStore.getNumDroppedSamples(); }
+
 private:
-    juce::dsp::DelayLine<float> leftDelay;
-    juce::dsp::DelayLine<float> rightDelay;
+    // delay memory, a line per channel, only the chunks written since the
+    // line was last silent are committed
+    ChunkedAudioStore delayStore;
+    int writePosition = 0;
+    static constexpr double maxDelaySeconds = 60.0;
 
     // set up parameters for the delay processor as a struct
     DelayParams delayParams = {0.5f, 0.5f, 0.5f};
 
     double currentSampleRate = 44100.0;
 
+    bool wetOnly = false;
+
+    // largest block the smoother buffers were prepared for
+    int maxBlockSize = 0;
+
+    // per-sample parameter ramps, delay time is smoothed in samples
+    ParameterSmoother delayTimeSmoother;
+    ParameterSmoother feedbackSmoother;
+    ParameterSmoother wetLevelSmoother;
+
+    static constexpr double delayTimeRampSeconds = 0.1;
+    static constexpr double gainRampSeconds = 0.02;
+
+    // highest feedback applied, the parameter goes up to 1 but a loop at
+    // unity gain builds up without limit while there's input
+    static constexpr float maxFeedback = 0.98f;
+
+    // skips blocks once the input and the echoes have died away
+    SilenceDetector silenceDetector;
+
+    // samples the echoes of input peaking at level ring for
+    [[nodiscard]] juce::int64 getTailSamples(float level) const noexcept;
+
+    // the per-sample kernel, for a mono or stereo block or (anyChannels) for
+    // however many channels the block has
+    static constexpr int anyChannels = 0;
+    template <int numChannels>
+    void processChunk(const juce::dsp::AudioBlock<float>& block);
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DelayProcessor)
 };
 
@@ -19,18 +19,69 @@ PluginProcessor::PluginProcessor()
     // TODO: PROCESSOR_ADDITION_CHAIN(2): Assign apvts values for new parameters
     //       here for each new processor
 
+    // standard delay parameters
+    delayTimeParam = apvts.getRawParameterValue("delayTime");
+    feedbackParam = apvts.getRawParameterValue("feedback");
+    wetDryParam = apvts.getRawParameterValue("wetDry");
+
+    // reverb parameters
+    reverbRoomSizeParam = apvts.getRawParameterValue("reverbRoomSize");
+    reverbDampingParam = apvts.getRawParameterValue("reverbDamping");
+    reverbMixParam = apvts.getRawParameterValue("reverbMix");
+    reverbWidthParam = apvts.getRawParameterValue("reverbWidth");
+    reverbFreezeParam = apvts.getRawParameterValue("reverbFreeze");
+    reverbToneParam = apvts.getRawParameterValue("reverbTone");
+
+    // granular delay parameters
+    granularDelayTimeParam = apvts.getRawParameterValue("granularDelayTime");
+    grainSizeParam = apvts.getRawParameterValue("grainSize");
+    grainDensityParam = apvts.getRawParameterValue("grainDensity");
+    granularPitchShiftParam = apvts.getRawParameterValue("pitchShift");
+    granularFeedbackParam = apvts.getRawParameterValue("granularFeedback");
+    granularWetDryParam = apvts.getRawParameterValue("granularWetDry");
+    granularSpreadParam = apvts.getRawParameterValue("spread");
+    grainWindowParam = apvts.getRawParameterValue("grainWindow");
+    grainQualityParam = apvts.getRawParameterValue("grainQuality");
+    grainScatterParam = apvts.getRawParameterValue("grainScatter");
+
+    // looper parameter
+    looperStateParam = apvts.getRawParameterValue("looperState");
+
     // signalPathManager parameter
     signalChainParam = apvts.getRawParameterValue("signalPath");
 
+    // resolve every processor parameter once, so the audio thread never has
+    // to look parameters up by name
+    signalPathManager.bindParameters(apvts);
+
+    // resolve what each MIDI controller drives, so processBlock only indexes
+    for (const auto& binding : midiControllerBindings)
+    {
+        auto& target = midiControllerTargets[static_cast<size_t>(binding.controller)];
+        const juce::String parameterId(binding.parameterId);
+
+        target.parameter = apvts.getParameter(parameterId);
+        jassert(target.parameter != nullptr);
+
+        if (parameterId == "looperState")
+            target.event.type = SignalPathManager::TimedEvent::looperState;
+        else
+            target.event.parameter = ParameterBindings::findParameter(parameterId);
+
+        jassert(target.event.type == SignalPathManager::TimedEvent::looperState || target.event.parameter >= 0);
+    }
+
     // Initialize the signalPathListener
     signalPathListener = std::make_unique<SignalPathParameterListener>(*this);
     apvts.addParameterListener("signalPath", signalPathListener.get());
+    apvts.addParameterListener("looperState", signalPathListener.get());
 }
 
 PluginProcessor::~PluginProcessor()
 {
     // Remove the signalPathListener
     apvts.removeParameterListener("signalPath", signalPathListener.get());
+    apvts.removeParameterListener("looperState", signalPathListener.get());
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout PluginProcessor::createParams()
@@ -61,6 +112,8 @@ juce::AudioProcessorValueTreeState::ParameterLayout PluginProcessor::createParam
         "Reverb Width", 0.0f, 1.0f, 0.5f));
     params.push_back(std::make_unique<juce::AudioParameterBool>("reverbFreeze",
         "Reverb Freeze Mode", false)); // binary toggle
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("reverbTone",
+        "Reverb Tone", juce::NormalisableRange<float>(1000.0f, 20000.0f, 1.0f, 0.3f), 12000.0f)); // low-pass cutoff in Hz
 
     // TODO: PROCESSOR_ADDITION_CHAIN(18): Add the new processing mode here
     // push processing mode parameter into the vector
@@ -70,7 +123,9 @@ juce::AudioProcessorValueTreeState::ParameterLayout PluginProcessor::createParam
             "Reverb Only",
             "Granular Only",
             "Looper Only",
-            "Serial"},
+            "Serial",
+            "Parallel",
+            "Send/Return"},
             0
         )
     );
@@ -90,6 +145,29 @@ juce::AudioProcessorValueTreeState::ParameterLayout PluginProcessor::createParam
         "Granular Wet/Dry Mix", 0.0f, 1.0f, 0.5f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("spread",
         "Spread", 0.0f, 1.0f, 0.5f));
+    // must match GrainWindowTables::WindowType
+    params.push_back(std::make_unique<juce::AudioParameterChoice>("grainWindow",
+        "Grain Window", juce::StringArray {
+            "Hann",
+            "Tukey",
+            "Gaussian",
+            "Trapezoid",
+            "Blackman-Harris"},
+            0
+        )
+    );
+    // must match Interpolation::Quality
+    params.push_back(std::make_unique<juce::AudioParameterChoice>("grainQuality",
+        "Grain Quality", juce::StringArray {
+            "Linear",
+            "Hermite",
+            "Lagrange",
+            "Sinc"},
+            0
+        )
+    );
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("grainScatter",
+        "Grain Scatter", 0.0f, 1.0f, 0.0f));
 
     // Replace the five boolean parameters with a single choice parameter
     params.push_back(std::make_unique<juce::AudioParameterChoice>(
@@ -140,7 +218,8 @@ bool PluginProcessor::isMidiEffect() const
 
 double PluginProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // worked out from the current graph and its settings on the audio thread
+    return signalPathManager.getTailLengthSeconds();
 }
 
 int PluginProcessor::getNumPrograms()
@@ -208,13 +287,19 @@ void PluginProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
         )
     );
 
+    // the reverb and the grain scatter need to know which channel is which
+    signalPathManager.setChannelLayout(getChannelLayoutOfBus(false, 0));
     signalPathManager.prepare(spec);
+
+    // the output limiter looks ahead, so the host has to compensate for it
+    setLatencySamples(signalPathManager.getLatencySamples());
 }
 
 void PluginProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    signalPathManager.releaseResources();
 }
 
 bool PluginProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
@@ -223,10 +308,11 @@ bool PluginProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // every processor runs on any number of channels, so mono, stereo,
+    // surround and ambisonic layouts all work, up to what the signal path
+    // manager is built for
+    const auto numChannels = layouts.getMainOutputChannelSet().size();
+    if (numChannels < 1 || numChannels > SignalPathManager::maxChannels)
         return false;
 
     // This checks if the input layout matches the output layout
@@ -242,8 +328,6 @@ bool PluginProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
 void PluginProcessor::processBlock (juce::AudioBuffer<float>& buffer,
                                               juce::MidiBuffer& midiMessages)
 {
-    juce::ignoreUnused (midiMessages);
-
     juce::ScopedNoDenormals noDenormals;
 
     //=error handling===========================================================
@@ -291,7 +375,10 @@ void PluginProcessor::processBlock (juce::AudioBuffer<float>& buffer,
 
     //=update the processor chain parameters====================================
 
-    signalPathManager.updateProcessorChainParameters(apvts);
+    signalPathManager.updateProcessorChainParameters();
+
+    // MIDI controller changes, which take effect at their own sample
+    const auto numEvents = collectMidiEvents(midiMessages);
 
     //=create audio block and context===========================================
 
@@ -300,8 +387,39 @@ void PluginProcessor::processBlock (juce::AudioBuffer<float>& buffer,
 
     //=process the signal through the signal path manager=======================
 
-    signalPathManager.process(context);
+    // split into sub-blocks at the events, or in one go if there are none
+    signalPathManager.processWithEvents(context, blockEvents.data(), numEvents);
+
+}
+
+int PluginProcessor::collectMidiEvents(const juce::MidiBuffer& midiMessages) noexcept
+{
+    int numEvents = 0;
+
+    // read the raw bytes, a MidiMessage might allocate. The buffer is already
+    // in sample order
+    for (const auto metadata : midiMessages)
+    {
+        if (metadata.numBytes != 3 || (metadata.data[0] & 0xf0) != 0xb0)
+            continue;
+
+        const auto& target = midiControllerTargets[static_cast<size_t>(metadata.data[1] & 0x7f)];
+        if (target.parameter == nullptr)
+            continue;
+
+        if (numEvents == maxEventsPerBlock)
+        {
+            jassertfalse; // more controller changes in one block than we have room for
+            break;
+        }
+
+        auto event = target.event;
+        event.sampleOffset = metadata.samplePosition;
+        event.value = target.parameter->convertFrom0to1(static_cast<float>(metadata.data[2] & 0x7f) / 127.0f);
+        blockEvents[static_cast<size_t>(numEvents++)] = event;
+    }
 
+    return numEvents;
 }
 
 //==============================================================================
@@ -5,6 +5,7 @@
 #include "AudioDSP/Reverb/ReverbProcessor.h"
 #include "AudioDSP/Standard-Delay/DelayProcessor.h"
 #include <juce_audio_processors/juce_audio_processors.h>
+#include <array>
 
 #if (MSVC)
 #include "ipps.h"
@@ -46,32 +47,36 @@ public:
 
     // TODO: PROCESSOR_ADDITION_CHAIN(1): add an atomic pointer here for each new parameter in the new processor
 
-    // // standard delay parameters
-    // std::atomic<float>* delayTimeParam; // delay length in seconds
-    // std::atomic<float>* feedbackParam;  // feedback amount
-    // std::atomic<float>* wetDryParam;    // wet/dry mix
-    //
-    // // reverb parameters
-    // std::atomic<float>* reverbRoomSizeParam;    // sets the size of the "room"
-    // std::atomic<float>* reverbDampingParam;     // sets the damping of high frequencies
-    // std::atomic<float>* reverbMixParam;         // sets the wet/dry mix of the reverb
-    // std::atomic<float>* reverbWidthParam;       // sets the stereo width of the reverb
-    // std::atomic<float>* reverbFreezeParam;      // sets the freeze mode of the reverb (now bool, but keep pointer for compatibility)
-    //
-    // // granular delay parameters
-    // std::atomic<float>* granularDelayTimeParam;     // delay time in seconds
-    // std::atomic<float>* grainSizeParam;             // grain size in seconds
-    // std::atomic<float>* grainDensityParam;          // grains per second
-    // std::atomic<float>* granularPitchShiftParam;    // pitch shift ratio (1.0 = no shift)
-    // std::atomic<float>* granularFeedbackParam;      // feedback level (0.0 to 1.0)
-    // std::atomic<float>* granularWetDryParam;        // wet/dry mix ratio (0.0 to 1.0)
-    // std::atomic<float>* granularSpreadParam;        // random position spread
-    //
-    // // looper state management parameter
-    // std::atomic<float>* looperStateParam; // 0 = recording, 1 = playing, 2 = overdubbing, 3 = stopped, 4 = clear
-    //
-    // // signal processing chain parameters
-     std::atomic<float>* signalChainParam;
+    // standard delay parameters
+    std::atomic<float>* delayTimeParam; // delay length in seconds
+    std::atomic<float>* feedbackParam;  // feedback amount
+    std::atomic<float>* wetDryParam;    // wet/dry mix
+
+    // reverb parameters
+    std::atomic<float>* reverbRoomSizeParam;    // sets the size of the "room"
+    std::atomic<float>* reverbDampingParam;     // sets the damping of high frequencies
+    std::atomic<float>* reverbMixParam;         // sets the wet/dry mix of the reverb
+    std::atomic<float>* reverbWidthParam;       // sets the stereo width of the reverb
+    std::atomic<float>* reverbFreezeParam;      // sets the freeze mode of the reverb (now bool, but keep pointer for compatibility)
+    std::atomic<float>* reverbToneParam;        // sets the cutoff of the low-pass tone filter after the reverb
+
+    // granular delay parameters
+    std::atomic<float>* granularDelayTimeParam;     // delay time in seconds
+    std::atomic<float>* grainSizeParam;             // grain size in seconds
+    std::atomic<float>* grainDensityParam;          // grains per second
+    std::atomic<float>* granularPitchShiftParam;    // pitch shift ratio (1.0 = no shift)
+    std::atomic<float>* granularFeedbackParam;      // feedback level (0.0 to 1.0)
+    std::atomic<float>* granularWetDryParam;        // wet/dry mix ratio (0.0 to 1.0)
+    std::atomic<float>* granularSpreadParam;        // random position spread
+    std::atomic<float>* grainWindowParam;           // grain envelope shape (GrainWindowTables::WindowType)
+    std::atomic<float>* grainQualityParam;          // grain interpolation quality (Interpolation::Quality)
+    std::atomic<float>* grainScatterParam;          // how far grains are panned around the output channels
+
+    // looper state management parameter
+    std::atomic<float>* looperStateParam; // 0 = recording, 1 = playing, 2 = overdubbing, 3 = stopped, 4 = clear
+
+    // signal processing chain parameters
+    std::atomic<float>* signalChainParam;
 
 
     // more fx parameters below here as we add classes to handle processing
@@ -81,6 +86,15 @@ public:
 
     void updateSignalPathManager(int newMode);
 
+    // threads that help render parallel branches, takes effect on the next
+    // prepareToPlay (0 renders everything on the audio thread). off by
+    // default, since every instance would start its own threads; a host or
+    // standalone wrapper that runs few instances enables it by calling this on
+    // the processor it created, before prepareToPlay (see
+    // benchmarks/ProcessingBenchmarks.cpp). it is not a parameter, so it is
+    // neither automatable nor saved with the state
+    void setNumWorkerThreads(int numWorkerThreads) { signalPathManager.setNumWorkerThreads(numWorkerThreads); }
+
 private:
     class SignalPathParameterListener : public juce::AudioProcessorValueTreeState::Listener
     {
@@ -95,6 +109,11 @@ private:
                     static_cast<SignalPathManager::ProcessingMode>(static_cast<int>(newValue))
                 );
             }
+            else if (parameterID == "looperState")
+            {
+                // queued, the audio thread applies it at the next block
+                processor.signalPathManager.setLooperState(static_cast<int>(newValue));
+            }
         }
 
     private:
@@ -105,6 +124,59 @@ private:
 
     SignalPathManager signalPathManager;
 
+    //=MIDI controllers=========================================================
+    // controllers that drive parameters. Each change becomes a timestamped
+    // event, so it takes effect at its own sample within the block. These are
+    // the undefined controller numbers, so they don't clash with a keyboard's
+    // mod wheel or sustain pedal
+    struct MidiControllerBinding
+    {
+        int controller;
+        const char* parameterId;
+    };
+
+    // TODO: PROCESSOR_ADDITION_CHAIN(32): give each new parameter a free
+    //       controller number here
+    static constexpr std::array<MidiControllerBinding, 20> midiControllerBindings {{
+        { 20, "delayTime" },
+        { 21, "feedback" },
+        { 22, "wetDry" },
+        { 23, "reverbRoomSize" },
+        { 24, "reverbDamping" },
+        { 25, "reverbMix" },
+        { 26, "reverbWidth" },
+        { 27, "reverbFreeze" },
+        { 28, "reverbTone" },
+        { 102, "granularDelayTime" },
+        { 103, "grainSize" },
+        { 104, "grainDensity" },
+        { 105, "pitchShift" },
+        { 106, "granularFeedback" },
+        { 107, "granularWetDry" },
+        { 108, "spread" },
+        { 109, "grainWindow" },
+        { 110, "grainQuality" },
+        { 111, "looperState" },
+        { 112, "grainScatter" }
+    }};
+
+    // by controller number: the parameter it drives (nullptr for none) and
+    // the event a change becomes, resolved once in the constructor
+    struct MidiControllerTarget
+    {
+        juce::RangedAudioParameter* parameter = nullptr;
+        SignalPathManager::TimedEvent event;
+    };
+
+    std::array<MidiControllerTarget, 128> midiControllerTargets {};
+
+    // this block's events, further controller changes are dropped
+    static constexpr int maxEventsPerBlock = 256;
+    std::array<SignalPathManager::TimedEvent, maxEventsPerBlock> blockEvents {};
+
+    // turn the block's controller changes into events (audio thread)
+    int collectMidiEvents(const juce::MidiBuffer& midiMessages) noexcept;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginProcessor)
 };
 
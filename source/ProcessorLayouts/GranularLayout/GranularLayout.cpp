@@ -17,6 +17,24 @@ GranularLayout::GranularLayout (juce::AudioProcessorValueTreeState& apvts)
     SliderSetup::setupRotarySlider(feedbackSlider, this);
     SliderSetup::setupRotarySlider(wetDrySlider, this);
     SliderSetup::setupRotarySlider(spreadSlider, this);
+    SliderSetup::setupRotarySlider(scatterSlider, this);
+
+    // initialize the window selector, items must match the choices in the
+    // grainWindow AudioParameterChoice in PluginProcessor.cpp
+    addAndMakeVisible(windowSelector);
+    windowSelector.addItem("Hann", 1);
+    windowSelector.addItem("Tukey", 2);
+    windowSelector.addItem("Gaussian", 3);
+    windowSelector.addItem("Trapezoid", 4);
+    windowSelector.addItem("Blackman-Harris", 5);
+
+    // initialize the quality selector, items must match the choices in the
+    // grainQuality AudioParameterChoice in PluginProcessor.cpp
+    addAndMakeVisible(qualitySelector);
+    qualitySelector.addItem("Linear", 1);
+    qualitySelector.addItem("Hermite", 2);
+    qualitySelector.addItem("Lagrange", 3);
+    qualitySelector.addItem("Sinc", 4);
 
     // initialize labels
     LabelSetup::setupLabel(delayTimeLabel, "Delay Time", this);
@@ -26,6 +44,9 @@ GranularLayout::GranularLayout (juce::AudioProcessorValueTreeState& apvts)
     LabelSetup::setupLabel(feedbackLabel, "Feedback", this);
     LabelSetup::setupLabel(wetDryLabel, "Wet/Dry Mix", this);
     LabelSetup::setupLabel(spreadLabel, "Spread", this);
+    LabelSetup::setupLabel(scatterLabel, "Scatter", this);
+    LabelSetup::setupLabel(windowLabel, "Window", this);
+    LabelSetup::setupLabel(qualityLabel, "Quality", this);
 
     // create slider attachments using the AttachmentSetup helper
     delayTimeAttachment = AttachmentSetup::createSliderAttachment(apvts, "granularDelayTime", delayTimeSlider);
@@ -35,6 +56,9 @@ GranularLayout::GranularLayout (juce::AudioProcessorValueTreeState& apvts)
     feedbackAttachment = AttachmentSetup::createSliderAttachment(apvts, "granularFeedback", feedbackSlider);
     wetDryAttachment = AttachmentSetup::createSliderAttachment(apvts, "granularWetDry", wetDrySlider);
     spreadAttachment = AttachmentSetup::createSliderAttachment(apvts, "spread", spreadSlider);
+    scatterAttachment = AttachmentSetup::createSliderAttachment(apvts, "grainScatter", scatterSlider);
+    windowAttachment = AttachmentSetup::createComboBoxAttachment(apvts, "grainWindow", windowSelector);
+    qualityAttachment = AttachmentSetup::createComboBoxAttachment(apvts, "grainQuality", qualitySelector);
 }
 
 void GranularLayout::resized()
@@ -52,6 +76,8 @@ void GranularLayout::resized()
     topControls.items.add(juce::FlexItem(delayTimeSlider).withFlex(1));
     topControls.items.add(juce::FlexItem(grainSizeSlider).withFlex(1));
     topControls.items.add(juce::FlexItem(grainDensitySlider).withFlex(1));
+    topControls.items.add(juce::FlexItem(windowSelector).withFlex(1).withMaxHeight(24).withAlignSelf(juce::FlexItem::AlignSelf::center));
+    topControls.items.add(juce::FlexItem(qualitySelector).withFlex(1).withMaxHeight(24).withAlignSelf(juce::FlexItem::AlignSelf::center));
 
     // upper row labels
     juce::FlexBox topLabels;
@@ -61,6 +87,8 @@ void GranularLayout::resized()
     topLabels.items.add(juce::FlexItem(delayTimeLabel).withFlex(1));
     topLabels.items.add(juce::FlexItem(grainSizeLabel).withFlex(1));
     topLabels.items.add(juce::FlexItem(grainDensityLabel).withFlex(1));
+    topLabels.items.add(juce::FlexItem(windowLabel).withFlex(1));
+    topLabels.items.add(juce::FlexItem(qualityLabel).withFlex(1));
 
     // lower row controls
     juce::FlexBox bottomControls;
@@ -71,6 +99,7 @@ void GranularLayout::resized()
     bottomControls.items.add(juce::FlexItem(feedbackSlider).withFlex(1));
     bottomControls.items.add(juce::FlexItem(wetDrySlider).withFlex(1));
     bottomControls.items.add(juce::FlexItem(spreadSlider).withFlex(1));
+    bottomControls.items.add(juce::FlexItem(scatterSlider).withFlex(1));
 
     // lower row labels
     juce::FlexBox bottomLabels;
@@ -81,6 +110,7 @@ void GranularLayout::resized()
     bottomLabels.items.add(juce::FlexItem(feedbackLabel).withFlex(1));
     bottomLabels.items.add(juce::FlexItem(wetDryLabel).withFlex(1));
     bottomLabels.items.add(juce::FlexItem(spreadLabel).withFlex(1));
+    bottomLabels.items.add(juce::FlexItem(scatterLabel).withFlex(1));
 
     // perform layouts
     topControls.performLayout(bounds.removeFromTop(60));
@@ -21,17 +21,22 @@ private:
     // sliders and labels
     juce::Slider delayTimeSlider, grainSizeSlider, grainDensitySlider,
                  pitchShiftSlider, feedbackSlider, wetDrySlider,
-                 spreadSlider;
+                 spreadSlider, scatterSlider;
     juce::Label delayTimeLabel, grainSizeLabel, grainDensityLabel,
                 pitchShiftLabel, feedbackLabel, wetDryLabel,
-                spreadLabel;
+                spreadLabel, scatterLabel, windowLabel, qualityLabel;
+
+    // grain window and interpolation quality selectors
+    juce::ComboBox windowSelector, qualitySelector;
 
     // attachments for the sliders
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>
                 delayTimeAttachment,
                 grainSizeAttachment, grainDensityAttachment,
                 pitchShiftAttachment, feedbackAttachment,
-                wetDryAttachment, spreadAttachment;
+                wetDryAttachment, spreadAttachment, scatterAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>
+                windowAttachment, qualityAttachment;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GranularLayout)
 };
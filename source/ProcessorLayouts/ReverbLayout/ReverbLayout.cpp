@@ -15,6 +15,7 @@ ReverbLayout::ReverbLayout(juce::AudioProcessorValueTreeState& apvts)
     SliderSetup::setupRotarySlider(dampingSlider, this);
     SliderSetup::setupRotarySlider(mixSlider, this);
     SliderSetup::setupRotarySlider(widthSlider, this);
+    SliderSetup::setupRotarySlider(toneSlider, this);
     ToggleSetup::setupToggleButton(freezeButton, "Freeze", this);
 
     // set up reverb control labels
@@ -23,6 +24,7 @@ ReverbLayout::ReverbLayout(juce::AudioProcessorValueTreeState& apvts)
     LabelSetup::setupLabel(mixLabel, "Wet/Dry Mix", this);
     LabelSetup::setupLabel(widthLabel, "Width", this);
     LabelSetup::setupLabel(freezeLabel, "Freeze", this);
+    LabelSetup::setupLabel(toneLabel, "Tone", this);
 
     // set up attachments for reverb controls using the AttachmentSetup helper
     roomSizeAttach = AttachmentSetup::createSliderAttachment(apvts,
@@ -35,6 +37,8 @@ ReverbLayout::ReverbLayout(juce::AudioProcessorValueTreeState& apvts)
         "reverbWidth", widthSlider);
     freezeAttach = AttachmentSetup::createButtonAttachment(apvts,
         "reverbFreeze", freezeButton);
+    toneAttach = AttachmentSetup::createSliderAttachment(apvts,
+        "reverbTone", toneSlider);
 }
 
 void ReverbLayout::resized()
@@ -66,7 +70,7 @@ void ReverbLayout::resized()
 
     bottomControls.items.add(juce::FlexItem(widthSlider).withFlex(1));
     bottomControls.items.add(juce::FlexItem(freezeButton).withFlex(1));
-    bottomControls.items.add(juce::FlexItem().withFlex(1)); // empty space for balance
+    bottomControls.items.add(juce::FlexItem(toneSlider).withFlex(1));
 
     // lower row labels
     juce::FlexBox bottomLabels;
@@ -75,7 +79,7 @@ void ReverbLayout::resized()
 
     bottomLabels.items.add(juce::FlexItem(widthLabel).withFlex(1));
     bottomLabels.items.add(juce::FlexItem(freezeLabel).withFlex(1));
-    bottomLabels.items.add(juce::FlexItem().withFlex(1)); // empty space for balance
+    bottomLabels.items.add(juce::FlexItem(toneLabel).withFlex(1));
 
     // add spacing for label
     bounds.removeFromTop(20);
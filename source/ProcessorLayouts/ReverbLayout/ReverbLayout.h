@@ -19,14 +19,14 @@ public:
 
 private:
     // sliders, buttons and labels
-    juce::Slider roomSizeSlider, dampingSlider, mixSlider, widthSlider;
+    juce::Slider roomSizeSlider, dampingSlider, mixSlider, widthSlider, toneSlider;
     juce::TextButton freezeButton;
 
-    juce::Label roomSizeLabel, dampingLabel, mixLabel, widthLabel, freezeLabel;
+    juce::Label roomSizeLabel, dampingLabel, mixLabel, widthLabel, freezeLabel, toneLabel;
 
     // attachments
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>
-        roomSizeAttach, dampingAttach, mixAttach, widthAttach;
+        roomSizeAttach, dampingAttach, mixAttach, widthAttach, toneAttach;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> freezeAttach;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ReverbLayout)
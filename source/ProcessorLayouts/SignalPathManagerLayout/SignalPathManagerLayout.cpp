@@ -21,6 +21,8 @@ SignalPathManagerLayout::SignalPathManagerLayout (juce::AudioProcessorValueTreeS
     pathSelector.addItem("Granular Only", 3);
     pathSelector.addItem("Looper Only", 4);
     pathSelector.addItem("Serial", 5);
+    pathSelector.addItem("Parallel", 6);
+    pathSelector.addItem("Send/Return", 7);
 
     // add a label
     addAndMakeVisible(pathLabel);
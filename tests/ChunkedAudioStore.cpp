@@ -0,0 +1,47 @@
+#include <AudioDSP/DSPHelpers/ChunkedAudioStore/ChunkedAudioStore.h>
+#include <catch2/catch_test_macros.hpp>
+
+TEST_CASE ("Store reserve covers several service periods", "[chunkStore]")
+{
+    for (const auto sampleRate : { 44100.0, 48000.0, 96000.0, 192000.0 })
+    {
+        INFO ("sample rate " << sampleRate);
+        const auto reserve = ChunkedAudioStore::getReserveChunks (sampleRate, 2048);
+        const auto covered = static_cast<double> (reserve * ChunkedAudioStore::defaultChunkSize);
+        const auto needed = sampleRate * ChunkedAudioStore::reserveServicePeriods * ChunkPoolService::servicePeriodMs / 1000.0;
+
+        CHECK (reserve >= ChunkedAudioStore::defaultReserveChunks);
+        CHECK (covered >= needed + 2048);
+    }
+}
+
+TEST_CASE ("Writes the pool has no chunks for are counted", "[chunkStore]")
+{
+    constexpr int chunkSize = 256;
+    constexpr int numChunks = 64;
+
+    ChunkedAudioStore store;
+    store.prepare (1, chunkSize * numChunks, chunkSize, 1);
+    CHECK (store.getNumReserveChunks() == 1);
+    CHECK (store.getNumDroppedSamples() == 0);
+
+    // far more chunks in one go than a one chunk pool can hand out, even if
+    // the service thread tops it up once or twice meanwhile
+    std::vector<float> input (static_cast<size_t> (chunkSize * numChunks), 1.0f);
+    CHECK_FALSE (store.ensureMapped (0, chunkSize * numChunks));
+    store.copyIn (0, 0, input.data(), chunkSize * numChunks);
+
+    const auto mapped = store.getNumMappedChunks();
+    CHECK (mapped < numChunks / 2);
+    CHECK (store.getNumDroppedSamples() == static_cast<juce::int64> ((numChunks - mapped) * chunkSize));
+
+    // what did get stored reads back, the rest as silence
+    CHECK (store.read (0, 0) == 1.0f);
+    CHECK (store.read (0, chunkSize * numChunks - 1) == 0.0f);
+
+    // prepare starts counting again
+    store.prepare (1, chunkSize * numChunks, chunkSize, 1);
+    CHECK (store.getNumDroppedSamples() == 0);
+
+    store.release();
+}
@@ -0,0 +1,83 @@
+#include <AudioDSP/DSPHelpers/CommandQueue/CommandQueue.h>
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct TestCommand
+    {
+        int producer = 0;
+        int sequence = 0;
+    };
+}
+
+TEST_CASE ("Command queue keeps order and rejects pushes when full", "[commands]")
+{
+    CommandQueue<TestCommand, 4> queue;
+
+    for (int i = 0; i < 4; ++i)
+        REQUIRE (queue.push ({ 0, i }));
+    CHECK_FALSE (queue.push ({ 0, 4 }));
+
+    TestCommand command;
+    for (int i = 0; i < 4; ++i)
+    {
+        REQUIRE (queue.pop (command));
+        CHECK (command.sequence == i);
+    }
+    CHECK_FALSE (queue.pop (command));
+
+    // and the cells are reused after wrapping around
+    REQUIRE (queue.push ({ 0, 5 }));
+    REQUIRE (queue.pop (command));
+    CHECK (command.sequence == 5);
+}
+
+TEST_CASE ("Command queue delivers every command from several producers", "[commands]")
+{
+    constexpr int numProducers = 4;
+    constexpr int commandsPerProducer = 20000;
+
+    CommandQueue<TestCommand, 64> queue;
+
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < numProducers; ++producer)
+    {
+        producers.emplace_back ([&queue, producer]
+        {
+            for (int i = 0; i < commandsPerProducer; ++i)
+                while (! queue.push ({ producer, i }))
+                    std::this_thread::yield();
+        });
+    }
+
+    // every producer's commands arrive exactly once and in the order pushed
+    std::array<int, numProducers> next {};
+    int received = 0;
+    bool inOrder = true;
+
+    while (received < numProducers * commandsPerProducer)
+    {
+        TestCommand command;
+        if (! queue.pop (command))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        auto& expected = next[static_cast<size_t> (command.producer)];
+        inOrder = inOrder && command.sequence == expected;
+        expected = command.sequence + 1;
+        ++received;
+    }
+
+    for (auto& producer : producers)
+        producer.join();
+
+    CHECK (inOrder);
+    for (const auto count : next)
+        CHECK (count == commandsPerProducer);
+}
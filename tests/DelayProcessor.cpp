@@ -0,0 +1,47 @@
+#include <AudioDSP/Standard-Delay/DelayProcessor.h>
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+    constexpr int blockSize = 512;
+    constexpr double sampleRate = 48000.0;
+
+    // run seconds of noise through the delay, returning the peak of the last block
+    float runNoise (DelayProcessor& delay, juce::Random& random, double seconds)
+    {
+        juce::AudioBuffer<float> buffer (2, blockSize);
+        const auto numBlocks = static_cast<int> (seconds * sampleRate) / blockSize;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            for (int channel = 0; channel < 2; ++channel)
+                for (int i = 0; i < blockSize; ++i)
+                    buffer.setSample (channel, i, 0.5f * (random.nextFloat() * 2.0f - 1.0f));
+
+            juce::dsp::AudioBlock<float> audioBlock (buffer);
+            delay.process (juce::dsp::ProcessContextReplacing<float> (audioBlock));
+        }
+
+        return buffer.getMagnitude (0, blockSize);
+    }
+}
+
+TEST_CASE ("Lengthening the delay reads back audio from that long ago", "[delay]")
+{
+    DelayProcessor delay;
+    delay.prepare ({ sampleRate, blockSize, 2 });
+    juce::Random random (42);
+
+    // fully wet with no feedback, so the output is only the line
+    delay.updateParameters ({ 0.3f, 0.0f, 1.0f });
+    CHECK (runNoise (delay, random, 3.0) > 0.01f);
+
+    // the line still holds the audio from two seconds ago, so after the ramp
+    // the longer delay plays it rather than silence
+    delay.updateParameters ({ 2.0f, 0.0f, 1.0f });
+    CHECK (runNoise (delay, random, 0.25) > 0.01f);
+    CHECK (runNoise (delay, random, 0.25) > 0.01f);
+    CHECK (delay.getNumDroppedSamples() == 0);
+
+    delay.releaseResources();
+}
@@ -0,0 +1,414 @@
+#include <PluginProcessor.h>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+namespace
+{
+    // multiplies by a gain and adds an offset, so the order processors run in
+    // shows up in the output
+    class AffineProcessor : public juce::dsp::ProcessorBase
+    {
+    public:
+        AffineProcessor (float gainToUse, float offsetToUse) : gain (gainToUse), offset (offsetToUse) {}
+
+        void prepare (const juce::dsp::ProcessSpec&) override {}
+        void reset() override {}
+
+        void process (const juce::dsp::ProcessContextReplacing<float>& context) override
+        {
+            auto& block = context.getOutputBlock();
+            block.multiplyBy (gain);
+            block.add (offset);
+        }
+
+    private:
+        float gain, offset;
+    };
+
+    float runPlan (const ProcessingGraph& graph, float input, RealtimeWorkerPool* workers = nullptr, int numSamples = 64)
+    {
+        AffineProcessor first (2.0f, 0.0f), second (1.0f, 1.0f), third (0.5f, 0.0f);
+        juce::dsp::ProcessorBase* processors[] = { &first, &second, &third };
+
+        ExecutionPlan plan (graph, { 48000.0, 64, 2 });
+
+        juce::AudioBuffer<float> buffer (2, numSamples);
+        for (int channel = 0; channel < 2; ++channel)
+            juce::FloatVectorOperations::fill (buffer.getWritePointer (channel), input, numSamples);
+
+        juce::dsp::AudioBlock<float> block (buffer);
+        plan.process (block, processors, workers);
+
+        // every sample and channel should have come out the same
+        CHECK_THAT (buffer.getSample (1, numSamples - 1), Catch::Matchers::WithinAbs (buffer.getSample (0, 0), 1.0e-6));
+        return buffer.getSample (0, 0);
+    }
+
+    // process silent blocks until the manager runs the mode asked for. The
+    // warm-up thread prepares the new processors and publishes the plan, the
+    // audio thread swaps it in at the start of a block (after any duck)
+    bool switchTo (SignalPathManager& manager, SignalPathManager::ProcessingMode mode)
+    {
+        juce::AudioBuffer<float> buffer (2, 64);
+        for (int attempt = 0; attempt < 500 && manager.getCurrentMode() != mode; ++attempt)
+        {
+            buffer.clear();
+            juce::dsp::AudioBlock<float> block (buffer);
+            manager.process (juce::dsp::ProcessContextReplacing<float> (block));
+            juce::Thread::sleep (2);
+        }
+
+        return manager.getCurrentMode() == mode;
+    }
+}
+
+TEST_CASE ("Execution plan runs serial stages in graph order", "[signalPath][graph]")
+{
+    ProcessingGraph forwards;
+    forwards.then ({ 0, 1, 2 });
+    CHECK_THAT (runPlan (forwards, 1.0f), Catch::Matchers::WithinAbs (1.5, 1.0e-6)); // ((1 * 2) + 1) * 0.5
+
+    ProcessingGraph backwards;
+    backwards.then ({ 2 }).then ({ 1 }).then ({ 0 });
+    CHECK_THAT (runPlan (backwards, 1.0f), Catch::Matchers::WithinAbs (3.0, 1.0e-6)); // ((1 * 0.5) + 1) * 2
+
+    ProcessingGraph empty;
+    CHECK_THAT (runPlan (empty, 0.25f), Catch::Matchers::WithinAbs (0.25, 1.0e-6));
+}
+
+TEST_CASE ("Execution plan sums parallel branches with their mix", "[signalPath][graph]")
+{
+    // every branch starts from the stage input, not the previous branch
+    ProcessingGraph graph;
+    graph.split ({ { { 0 }, 0.5f }, { { 1, 2 }, 0.25f }, { {}, 1.0f } });
+    CHECK_THAT (runPlan (graph, 1.0f), Catch::Matchers::WithinAbs (2.25, 1.0e-6)); // 2 * 0.5 + ((1 + 1) * 0.5) * 0.25 + 1
+
+    // stages after a split see the summed signal
+    ProcessingGraph splitThenSerial;
+    splitThenSerial.split ({ { { 0 }, 0.5f }, { { 1 }, 0.25f }, { {}, 1.0f } }).then ({ 2 });
+    CHECK_THAT (runPlan (splitThenSerial, 1.0f), Catch::Matchers::WithinAbs (1.25, 1.0e-6)); // (1 + 0.5 + 1) * 0.5
+}
+
+TEST_CASE ("Parallel branches give the same result on worker threads", "[signalPath][graph][workers]")
+{
+    RealtimeWorkerPool workers (2, false);
+
+    ProcessingGraph graph;
+    graph.split ({ { { 0 }, 0.5f }, { { 1 }, 0.25f }, { { 2 }, 1.0f } });
+
+    const auto serial = runPlan (graph, 1.0f);
+    for (int run = 0; run < 100; ++run)
+        REQUIRE_THAT (runPlan (graph, 1.0f, &workers), Catch::Matchers::WithinAbs (serial, 1.0e-6));
+
+    // too short to hand over, but still the same
+    CHECK_THAT (runPlan (graph, 1.0f, &workers, static_cast<int> (ExecutionPlan::minParallelSamples) - 1),
+                Catch::Matchers::WithinAbs (serial, 1.0e-6));
+}
+
+TEST_CASE ("Decaying branches flush to zero on worker threads", "[signalPath][graph][workers][guard]")
+{
+    // rings out from full scale, through the denormal range unless the
+    // thread flushes denormals to zero
+    class DecayProcessor : public juce::dsp::ProcessorBase
+    {
+    public:
+        void prepare (const juce::dsp::ProcessSpec&) override {}
+        void reset() override { levels.fill (1.0f); }
+
+        void process (const juce::dsp::ProcessContextReplacing<float>& context) override
+        {
+            auto& block = context.getOutputBlock();
+            for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+            {
+                auto* samples = block.getChannelPointer (channel);
+                for (size_t i = 0; i < block.getNumSamples(); ++i)
+                    samples[i] = (levels[channel] *= 0.9f);
+            }
+        }
+
+        std::array<float, 2> levels { 1.0f, 1.0f };
+    };
+
+    RealtimeWorkerPool workers (3, false);
+    DecayProcessor first, second, third;
+    juce::dsp::ProcessorBase* processors[] = { &first, &second, &third };
+
+    ProcessingGraph graph;
+    graph.split ({ { { 0 }, 1.0f }, { { 1 }, 1.0f }, { { 2 }, 1.0f } });
+    ExecutionPlan plan (graph, { 48000.0, 64, 2 });
+
+    // the host calls us with denormals off, the workers have to match
+    juce::ScopedNoDenormals noDenormals;
+    juce::AudioBuffer<float> buffer (2, 64);
+    juce::dsp::AudioBlock<float> block (buffer);
+
+    // long enough for every branch to ring down to nothing
+    for (int round = 0; round < 40; ++round)
+    {
+        block.clear();
+        plan.process (block, processors, &workers);
+
+        // a denormal in a quiet block would trip the guard and reset the
+        // processor, but only on the threads that don't flush them
+        INFO ("block " << round);
+        REQUIRE (plan.takeTrippedProcessors() == 0);
+    }
+
+    for (auto* processor : { &first, &second, &third })
+        CHECK (processor->levels[0] == 0.0f);
+}
+
+TEST_CASE ("A processor that blows up is reset on its own", "[signalPath][graph][guard]")
+{
+    // writes a NaN into its block until it's reset
+    class BrokenProcessor : public juce::dsp::ProcessorBase
+    {
+    public:
+        void prepare (const juce::dsp::ProcessSpec&) override {}
+        void reset() override { ++numResets; broken = false; }
+
+        void process (const juce::dsp::ProcessContextReplacing<float>& context) override
+        {
+            if (broken)
+                context.getOutputBlock().setSample (1, 10, std::numeric_limits<float>::quiet_NaN());
+        }
+
+        bool broken = true;
+        int numResets = 0;
+    };
+
+    AffineProcessor dry (1.0f, 0.0f), wet (2.0f, 0.0f);
+    BrokenProcessor broken;
+    juce::dsp::ProcessorBase* processors[] = { &dry, &broken, &wet };
+
+    // the broken processor sits on a branch of its own
+    ProcessingGraph graph;
+    graph.split ({ { { 0 }, 1.0f }, { { 1, 2 }, 1.0f } });
+    ExecutionPlan plan (graph, { 48000.0, 64, 2 });
+
+    juce::AudioBuffer<float> buffer (2, 64);
+    juce::dsp::AudioBlock<float> block (buffer);
+
+    // its branch drops out, the other one comes through
+    block.fill (1.0f);
+    plan.process (block, processors);
+    CHECK (broken.numResets == 1);
+    CHECK (plan.takeTrippedProcessors() == (1u << 1));
+    CHECK (plan.takeTrippedProcessors() == 0);
+    CHECK_THAT (buffer.getSample (1, 10), Catch::Matchers::WithinAbs (1.0, 1.0e-6));
+
+    // and once reset it's back in the mix
+    block.fill (1.0f);
+    plan.process (block, processors);
+    CHECK (broken.numResets == 1);
+    CHECK (plan.takeTrippedProcessors() == 0);
+    CHECK_THAT (buffer.getSample (1, 10), Catch::Matchers::WithinAbs (3.0, 1.0e-6));
+}
+
+TEST_CASE ("A processor that keeps its state only loses its block", "[signalPath][graph][guard]")
+{
+    // stands in for the looper: reset would throw away a recording
+    class BrokenProcessor : public juce::dsp::ProcessorBase
+    {
+    public:
+        void prepare (const juce::dsp::ProcessSpec&) override {}
+        void reset() override { ++numResets; }
+
+        void process (const juce::dsp::ProcessContextReplacing<float>& context) override
+        {
+            context.getOutputBlock().setSample (0, 3, std::numeric_limits<float>::infinity());
+        }
+
+        int numResets = 0;
+    };
+
+    BrokenProcessor broken;
+    juce::dsp::ProcessorBase* processors[] = { &broken };
+
+    ProcessingGraph graph;
+    graph.then ({ 0 });
+    ExecutionPlan plan (graph, { 48000.0, 64, 2 }, 1u << 0);
+
+    juce::AudioBuffer<float> buffer (2, 64);
+    juce::dsp::AudioBlock<float> block (buffer);
+
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        block.fill (1.0f);
+        plan.process (block, processors);
+        CHECK (plan.takeTrippedProcessors() == (1u << 0));
+        CHECK (buffer.getSample (0, 3) == 0.0f);
+        CHECK (buffer.getSample (1, 63) == 0.0f);
+    }
+
+    CHECK (broken.numResets == 0);
+}
+
+TEST_CASE ("Send stages add their returns onto one dry path", "[signalPath][graph]")
+{
+    ProcessingGraph graph;
+    graph.sends ({ { { 0 } }, { { 1, 2 }, 0.5f } }, 0.25f);
+    CHECK (graph.getWetOnlyMask() == 0b111u);
+    CHECK_THAT (runPlan (graph, 1.0f), Catch::Matchers::WithinAbs (2.75, 1.0e-6)); // 1 * 0.25 + 2 + ((1 + 1) * 0.5) * 0.5
+
+    // the dry path of a send stage isn't a processor
+    ProcessingGraph dryOnly;
+    dryOnly.sends ({}, 0.5f);
+    CHECK (dryOnly.getProcessorMask() == 0);
+    CHECK_THAT (runPlan (dryOnly, 1.0f), Catch::Matchers::WithinAbs (0.5, 1.0e-6));
+}
+
+TEST_CASE ("Wet only processors leave out exactly their dry signal", "[signalPath][sends]")
+{
+    GranularProcessor::GranularParams params;
+    params.delayTime = 0.01f;
+    params.grainSize = 0.005f;
+    params.grainDensity = 10.0f;
+    params.feedback = 0.0f;
+    params.wetDryMix = 0.5f;
+
+    // both start from the same seed, so they spawn the same grains
+    GranularProcessor mixed, wetOnly;
+    for (auto* granular : { &mixed, &wetOnly })
+    {
+        granular->updateParameters (params);
+        granular->prepare ({ 48000.0, 256, 2 });
+    }
+    wetOnly.setWetOnly (true);
+
+    juce::AudioBuffer<float> mixedBuffer (2, 256), wetBuffer (2, 256), dryBuffer (2, 256);
+    float largestWet = 0.0f;
+
+    for (int block = 0; block < 40; ++block)
+    {
+        for (int channel = 0; channel < 2; ++channel)
+            for (int i = 0; i < 256; ++i)
+                dryBuffer.setSample (channel, i, std::sin (static_cast<float> (block * 256 + i) * 0.05f));
+
+        mixedBuffer.makeCopyOf (dryBuffer, true);
+        wetBuffer.makeCopyOf (dryBuffer, true);
+
+        juce::dsp::AudioBlock<float> mixedBlock (mixedBuffer), wetBlock (wetBuffer);
+        mixed.process (juce::dsp::ProcessContextReplacing<float> (mixedBlock));
+        wetOnly.process (juce::dsp::ProcessContextReplacing<float> (wetBlock));
+
+        // mixed = wet * mix + dry * (1 - mix), and a send stage adds the dry
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            for (int i = 0; i < 256; ++i)
+            {
+                const auto wet = wetBuffer.getSample (channel, i);
+                REQUIRE_THAT (mixedBuffer.getSample (channel, i),
+                              Catch::Matchers::WithinAbs (wet + 0.5f * dryBuffer.getSample (channel, i), 1.0e-5));
+                largestWet = juce::jmax (largestWet, std::abs (wet));
+            }
+        }
+    }
+
+    // and the grains did play
+    CHECK (largestWet > 0.01f);
+}
+
+TEST_CASE ("Graphs can only use each processor once", "[signalPath][graph]")
+{
+    ProcessingGraph graph;
+    graph.then ({ SignalPathManager::delay, SignalPathManager::reverb });
+    CHECK (graph.isValid());
+    CHECK (graph.getProcessorMask() == ((1u << SignalPathManager::delay) | (1u << SignalPathManager::reverb)));
+
+    graph.split ({ { { SignalPathManager::looper }, 0.5f }, { { SignalPathManager::delay }, 0.5f } });
+    CHECK_FALSE (graph.isValid());
+}
+
+TEST_CASE ("Every processing mode has a valid graph", "[signalPath][graph]")
+{
+    for (int mode = 0; mode <= SignalPathManager::SendReturn; ++mode)
+    {
+        INFO ("processing mode " << mode);
+        const auto graph = SignalPathManager::getGraphForMode (static_cast<SignalPathManager::ProcessingMode> (mode));
+        CHECK (graph.isValid());
+        CHECK (graph.getProcessorMask() != 0);
+    }
+}
+
+TEST_CASE ("A custom graph is compiled and swapped in", "[signalPath][graph]")
+{
+    SignalPathManager manager;
+    manager.prepare ({ 48000.0, 64, 2 });
+
+    ProcessingGraph invalid;
+    invalid.then ({ SignalPathManager::delay, SignalPathManager::delay });
+    CHECK_FALSE (manager.setGraph (invalid));
+
+    ProcessingGraph graph;
+    graph.then ({ SignalPathManager::delay }).sends ({ { { SignalPathManager::reverb }, 0.5f } });
+    REQUIRE (manager.setGraph (graph));
+
+    REQUIRE (switchTo (manager, SignalPathManager::Custom));
+    CHECK (manager.getDelayProcessor() != nullptr);
+    CHECK (manager.getReverbProcessor() != nullptr);
+    CHECK (manager.getLooperProcessor() == nullptr);
+    CHECK (manager.getGranularProcessor() == nullptr);
+
+    manager.releaseResources();
+}
+
+TEST_CASE ("Tails of parallel branches don't add up", "[signalPath][graph]")
+{
+    SignalPathManager manager;
+    manager.prepare ({ 48000.0, 64, 2 });
+
+    // the looper is stopped, so the tail is the longest of the three returns
+    manager.setProcessingMode (SignalPathManager::SendReturn);
+    REQUIRE (switchTo (manager, SignalPathManager::SendReturn));
+
+    const auto longest = juce::jmax (manager.getDelayProcessor()->getTailLengthSeconds(),
+                                     manager.getGranularProcessor()->getTailLengthSeconds(),
+                                     manager.getReverbProcessor()->getTailLengthSeconds());
+    CHECK (longest > 0.0);
+    CHECK_THAT (manager.getTailLengthSeconds(), Catch::Matchers::WithinAbs (juce::jmin (longest, SilenceDetector::longestTailSeconds), 1.0e-9));
+
+    manager.releaseResources();
+}
+
+TEST_CASE ("The grain pool size reaches the granular delay", "[signalPath][granular]")
+{
+    SignalPathManager manager;
+    manager.setMaxGrains (1024);
+    manager.setProcessingMode (SignalPathManager::GranularOnly);
+    manager.prepare ({ 48000.0, 512, 2 });
+
+    REQUIRE (switchTo (manager, SignalPathManager::GranularOnly));
+    auto* granular = manager.getGranularProcessor();
+    REQUIRE (granular != nullptr);
+    CHECK (granular->getMaxGrains() == 1024);
+
+    // as many long grains as the parameters allow, all playing at once
+    GranularProcessor::GranularParams params;
+    params.grainDensity = 100.0f;
+    params.grainSize = 2.0f;
+    params.delayTime = 0.1f;
+    params.wetDryMix = 1.0f;
+    granular->updateParameters (params);
+
+    juce::AudioBuffer<float> buffer (2, 512);
+    juce::Random random (1024);
+    float largest = 0.0f;
+
+    for (int block = 0; block < 250; ++block)
+    {
+        for (int channel = 0; channel < 2; ++channel)
+            for (int i = 0; i < 512; ++i)
+                buffer.setSample (channel, i, 0.25f * (random.nextFloat() * 2.0f - 1.0f));
+
+        juce::dsp::AudioBlock<float> block (buffer);
+        manager.process (juce::dsp::ProcessContextReplacing<float> (block));
+        largest = juce::jmax (largest, buffer.getMagnitude (0, 512), buffer.getMagnitude (1, 512));
+    }
+
+    CHECK (largest > 0.0f);
+    CHECK (largest <= OutputLimiter::ceiling * 1.01f);
+    CHECK (manager.getNumGuardTrips() == 0);
+
+    manager.releaseResources();
+}
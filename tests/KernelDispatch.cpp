@@ -0,0 +1,132 @@
+#include <AudioDSP/DSPHelpers/KernelDispatch/KernelDispatch.h>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+#include <limits>
+#include <vector>
+
+namespace
+{
+    constexpr int bufferSize = 1 << 12;
+    constexpr int numSamples = 509; // not a multiple of any vector width
+
+    // the wider builds fuse multiplies and reorder sums, so they only match the
+    // generic build to within rounding
+    constexpr double tolerance = 1.0e-5;
+
+    std::vector<const KernelDispatch::Kernels*> supportedKernels()
+    {
+        std::vector<const KernelDispatch::Kernels*> kernels;
+        for (int isa = 0; isa < KernelDispatch::numIsas; ++isa)
+            if (KernelDispatch::isSupported (static_cast<KernelDispatch::Isa> (isa)))
+                kernels.push_back (&KernelDispatch::getKernels (static_cast<KernelDispatch::Isa> (isa)));
+
+        return kernels;
+    }
+}
+
+TEST_CASE ("Every supported instruction set matches the generic kernels", "[kernels]")
+{
+    const auto& generic = KernelDispatch::getKernels (KernelDispatch::Generic);
+
+    juce::Random random (42);
+    std::vector<float> data (bufferSize), source (numSamples), gains (numSamples);
+    for (auto& sample : data)
+        sample = random.nextFloat() * 2.0f - 1.0f;
+    for (int i = 0; i < numSamples; ++i)
+    {
+        source[static_cast<size_t> (i)] = random.nextFloat() * 2.0f - 1.0f;
+        gains[static_cast<size_t> (i)] = random.nextFloat();
+    }
+
+    SECTION ("interpolated reads")
+    {
+        Interpolation::SincTable sincTable;
+        sincTable.prepare();
+
+        // start near the end so the reads wrap around the buffer
+        std::vector<int> indices (numSamples);
+        std::vector<float> fractions (numSamples), expected (numSamples), actual (numSamples);
+        Interpolation::computePositions (bufferSize - 100.25f, 1.37f, indices.data(), fractions.data(), numSamples);
+
+        for (int quality = 0; quality < Interpolation::numQualities; ++quality)
+        {
+            const auto q = static_cast<Interpolation::Quality> (quality);
+            generic.gather (q, data.data(), bufferSize - 1, indices.data(), fractions.data(), expected.data(), numSamples, sincTable);
+
+            for (const auto* kernels : supportedKernels())
+            {
+                INFO (KernelDispatch::getIsaName (kernels->isa) << " quality " << quality);
+                kernels->gather (q, data.data(), bufferSize - 1, indices.data(), fractions.data(), actual.data(), numSamples, sincTable);
+
+                for (size_t i = 0; i < expected.size(); ++i)
+                    REQUIRE_THAT (actual[i], Catch::Matchers::WithinAbs (expected[i], tolerance));
+            }
+        }
+    }
+
+    SECTION ("accumulation and mix")
+    {
+        std::vector<float> expected (data.begin(), data.begin() + numSamples);
+        generic.addWithMultiply (expected.data(), source.data(), gains.data(), numSamples);
+        generic.mix (expected.data(), source.data(), gains.data(), numSamples);
+
+        for (const auto* kernels : supportedKernels())
+        {
+            INFO (KernelDispatch::getIsaName (kernels->isa));
+            std::vector<float> actual (data.begin(), data.begin() + numSamples);
+            kernels->addWithMultiply (actual.data(), source.data(), gains.data(), numSamples);
+            kernels->mix (actual.data(), source.data(), gains.data(), numSamples);
+
+            for (size_t i = 0; i < expected.size(); ++i)
+                REQUIRE_THAT (actual[i], Catch::Matchers::WithinAbs (expected[i], tolerance));
+        }
+    }
+
+    SECTION ("block scans")
+    {
+        std::vector<float> samples (source);
+        samples[100] = -1.5f;
+
+        for (const auto* kernels : supportedKernels())
+        {
+            INFO (KernelDispatch::getIsaName (kernels->isa));
+
+            // the peak ignores the sign, and exactly matches on every set
+            auto found = kernels->scan (samples.data(), numSamples);
+            CHECK (found.isFinite());
+            CHECK (found.getPeak() == 1.5f);
+            CHECK_FALSE (found.hasDenormals);
+
+            // zeros aren't denormals, the smallest positive float is
+            std::vector<float> quiet (numSamples, 0.0f);
+            CHECK_FALSE (kernels->scan (quiet.data(), numSamples).hasDenormals);
+            quiet[numSamples - 1] = -std::numeric_limits<float>::denorm_min();
+            CHECK (kernels->scan (quiet.data(), numSamples).hasDenormals);
+
+            // NaN and infinity both come out as not finite, in the scalar tail too
+            auto broken = samples;
+            broken[numSamples - 1] = std::numeric_limits<float>::quiet_NaN();
+            CHECK_FALSE (kernels->scan (broken.data(), numSamples).isFinite());
+            broken[numSamples - 1] = -std::numeric_limits<float>::infinity();
+            CHECK_FALSE (kernels->scan (broken.data(), numSamples).isFinite());
+        }
+    }
+}
+
+TEST_CASE ("The instruction set override is clamped to what the CPU supports", "[kernels]")
+{
+    const auto best = KernelDispatch::getBestSupportedIsa();
+    REQUIRE (KernelDispatch::isSupported (best));
+    CHECK (KernelDispatch::selectIsa() == best);
+
+    KernelDispatch::setIsaOverride (KernelDispatch::Generic);
+    CHECK (KernelDispatch::selectIsa() == KernelDispatch::Generic);
+
+    KernelDispatch::setIsaOverride (KernelDispatch::Avx512);
+    CHECK (KernelDispatch::selectIsa() == best);
+    CHECK (KernelDispatch::isSupported (KernelDispatch::selectIsa()));
+
+    KernelDispatch::clearIsaOverride();
+    CHECK (KernelDispatch::selectIsa() == best);
+}
@@ -0,0 +1,101 @@
+#include <AudioDSP/SignalPathManager/OutputLimiter.h>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+namespace
+{
+    constexpr int blockSize = 128;
+    constexpr double sampleRate = 48000.0;
+
+    // run a signal through the limiter in blocks, returning the output with
+    // the latency taken out
+    std::vector<float> runLimiter (OutputLimiter& limiter, const std::vector<float>& input)
+    {
+        const auto latency = limiter.getLatencySamples();
+        const auto numSamples = static_cast<int> (input.size());
+        juce::AudioBuffer<float> buffer (1, blockSize);
+        std::vector<float> output;
+
+        for (int start = 0; start < numSamples + latency; start += blockSize)
+        {
+            for (int i = 0; i < blockSize; ++i)
+                buffer.setSample (0, i, start + i < numSamples ? input[static_cast<size_t> (start + i)] : 0.0f);
+
+            juce::dsp::AudioBlock<float> block (buffer);
+            limiter.process (block);
+
+            for (int i = 0; i < blockSize; ++i)
+                if (start + i >= latency && start + i - latency < numSamples)
+                    output.push_back (buffer.getSample (0, i));
+        }
+
+        return output;
+    }
+}
+
+TEST_CASE ("Limiter passes quiet signals through unchanged, only delayed", "[limiter]")
+{
+    OutputLimiter limiter;
+    limiter.prepare ({ sampleRate, blockSize, 1 });
+    CHECK (limiter.getLatencySamples() > 0);
+
+    std::vector<float> input (4096);
+    for (size_t i = 0; i < input.size(); ++i)
+        input[i] = 0.5f * std::sin (static_cast<float> (i) * 0.01f);
+
+    const auto output = runLimiter (limiter, input);
+    REQUIRE (output.size() == input.size());
+    for (size_t i = 0; i < input.size(); ++i)
+        REQUIRE (output[i] == input[i]);
+
+    CHECK (limiter.getCurrentGain() == 1.0f);
+}
+
+TEST_CASE ("Limiter keeps true peaks under the ceiling, then recovers", "[limiter]")
+{
+    OutputLimiter limiter;
+    limiter.prepare ({ sampleRate, blockSize, 1 });
+
+    // a loud burst at a quarter of the sample rate with its peaks between
+    // the samples, which a sample peak meter reads 3 dB low, then two
+    // seconds for the gain to recover
+    std::vector<float> input (static_cast<size_t> (sampleRate * 2.0), 0.0f);
+    for (size_t i = 2000; i < 4000; ++i)
+        input[i] = 4.0f * std::sin (juce::MathConstants<float>::halfPi * static_cast<float> (i) + juce::MathConstants<float>::pi * 0.25f);
+
+    const auto output = runLimiter (limiter, input);
+    REQUIRE (output.size() == input.size());
+
+    float largest = 0.0f;
+    for (size_t i = 1; i < output.size(); ++i)
+    {
+        // both samples and the midpoint between them, which is where this
+        // signal's true peaks are
+        largest = juce::jmax (largest, std::abs (output[i]));
+        largest = juce::jmax (largest, std::abs (output[i] + output[i - 1]) * 0.5f * juce::MathConstants<float>::sqrt2);
+    }
+
+    CHECK (largest <= OutputLimiter::ceiling * 1.01f);
+
+    // it recovers after the burst
+    CHECK (limiter.getCurrentGain() == 1.0f);
+}
+
+TEST_CASE ("Limiter reset forgets the audio in flight", "[limiter]")
+{
+    OutputLimiter limiter;
+    limiter.prepare ({ sampleRate, blockSize, 1 });
+
+    juce::AudioBuffer<float> buffer (1, blockSize);
+    juce::dsp::AudioBlock<float> block (buffer);
+    block.fill (2.0f);
+    limiter.process (block);
+
+    limiter.reset();
+    CHECK (limiter.getCurrentGain() == 1.0f);
+
+    block.clear();
+    limiter.process (block);
+    for (int i = 0; i < blockSize; ++i)
+        REQUIRE (buffer.getSample (0, i) == 0.0f);
+}
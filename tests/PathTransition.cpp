@@ -0,0 +1,117 @@
+#include <AudioDSP/SignalPathManager/PathTransition.h>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+namespace
+{
+    constexpr int blockSize = 64;
+    constexpr double sampleRate = 48000.0;
+
+    // crossfade over exactly one block
+    constexpr double fadeSeconds = blockSize / sampleRate;
+
+    // run one block through the transition, with both paths passing their
+    // input through plus whatever the outgoing one still has ringing
+    bool runBlock (PathTransition& transition, juce::AudioBuffer<float>& buffer, float input, float outgoingTail,
+                   juce::AudioBuffer<float>* outgoingCopy = nullptr)
+    {
+        juce::FloatVectorOperations::fill (buffer.getWritePointer (0), input, blockSize);
+        juce::dsp::AudioBlock<float> block (buffer);
+
+        auto outgoing = transition.beginBlock (block);
+        outgoing.add (outgoingTail);
+
+        if (outgoingCopy != nullptr)
+            outgoingCopy->copyFrom (0, 0, outgoing.getChannelPointer (0), blockSize);
+
+        return transition.endBlock (block, outgoing);
+    }
+}
+
+TEST_CASE ("Transition crossfades with equal power, then lets the tail ring out", "[signalPath][transition]")
+{
+    PathTransition transition;
+    transition.prepare ({ sampleRate, blockSize, 1 }, fadeSeconds);
+    REQUIRE (transition.isEnabled());
+
+    juce::AudioBuffer<float> buffer (1, blockSize), outgoing (1, blockSize);
+
+    transition.start (PathTransition::crossfade);
+    CHECK_FALSE (runBlock (transition, buffer, 1.0f, 0.0f, &outgoing));
+
+    // the outgoing input fades out as the incoming output fades in
+    CHECK_THAT (outgoing.getSample (0, 0), Catch::Matchers::WithinAbs (1.0, 1.0e-6));
+    for (int i = 0; i < blockSize; ++i)
+    {
+        const auto fadeOut = outgoing.getSample (0, i);
+        const auto fadeIn = buffer.getSample (0, i) - fadeOut;
+        REQUIRE_THAT (fadeIn * fadeIn + fadeOut * fadeOut, Catch::Matchers::WithinAbs (1.0, 1.0e-5));
+    }
+
+    // then the outgoing path only gets silence, and what it still holds is
+    // added at full level
+    CHECK_FALSE (runBlock (transition, buffer, 1.0f, 0.5f, &outgoing));
+    CHECK_THAT (outgoing.getSample (0, 0), Catch::Matchers::WithinAbs (0.5, 1.0e-6));
+    CHECK_THAT (buffer.getSample (0, blockSize - 1), Catch::Matchers::WithinAbs (1.5, 1.0e-6));
+
+    // a tail has to stay silent for a while before the transition ends
+    const auto holdBlocks = static_cast<int> (PathTransition::silenceHoldSeconds * sampleRate) / blockSize;
+    int blocks = 1;
+    while (!runBlock (transition, buffer, 1.0f, 0.0f))
+        REQUIRE (++blocks <= holdBlocks);
+
+    CHECK (blocks == holdBlocks);
+    CHECK_FALSE (transition.isActive());
+}
+
+TEST_CASE ("Transition fades out a tail that's released early", "[signalPath][transition]")
+{
+    PathTransition transition;
+    transition.prepare ({ sampleRate, blockSize, 1 }, fadeSeconds);
+
+    juce::AudioBuffer<float> buffer (1, blockSize);
+
+    // a tail that never decays, faded in after a duck
+    transition.start (PathTransition::fadeIn);
+    CHECK_FALSE (runBlock (transition, buffer, 0.0f, 1.0f));
+    CHECK_FALSE (runBlock (transition, buffer, 0.0f, 1.0f));
+    CHECK_THAT (buffer.getSample (0, 0), Catch::Matchers::WithinAbs (1.0, 1.0e-6));
+
+    // released, it's gone one fade length later
+    transition.requestRelease();
+    CHECK (runBlock (transition, buffer, 0.0f, 1.0f));
+    CHECK_THAT (buffer.getSample (0, 0), Catch::Matchers::WithinAbs (1.0, 1.0e-6));
+    CHECK (buffer.getSample (0, blockSize - 1) < 0.05f);
+    CHECK_FALSE (transition.isActive());
+}
+
+TEST_CASE ("Transition ducks out, then fades the new path in", "[signalPath][transition]")
+{
+    PathTransition transition;
+    transition.prepare ({ sampleRate, blockSize, 1 }, fadeSeconds);
+
+    juce::AudioBuffer<float> buffer (1, blockSize);
+    juce::dsp::AudioBlock<float> block (buffer);
+
+    // the current path fades out, then stays silent until the switch
+    transition.startDuck();
+    CHECK_FALSE (transition.isDucked());
+
+    block.fill (1.0f);
+    CHECK_FALSE (transition.endBlock (block, {}));
+    CHECK (transition.isDucked());
+    CHECK_THAT (buffer.getSample (0, 0), Catch::Matchers::WithinAbs (1.0, 1.0e-6));
+    CHECK (buffer.getSample (0, blockSize - 1) < 0.05f);
+
+    block.fill (1.0f);
+    CHECK_FALSE (transition.endBlock (block, {}));
+    CHECK (buffer.getSample (0, 0) == 0.0f);
+
+    // with no tail to keep, the transition ends once the new path is in
+    transition.start (PathTransition::fadeIn, false);
+    block.fill (1.0f);
+    CHECK (transition.endBlock (block, {}));
+    CHECK (buffer.getSample (0, 0) < 0.05f);
+    CHECK_THAT (buffer.getSample (0, blockSize - 1), Catch::Matchers::WithinAbs (1.0, 0.05));
+    CHECK_FALSE (transition.isActive());
+}
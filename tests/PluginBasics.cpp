@@ -52,6 +52,7 @@ TEST_CASE ("Parameter initialization", "[parameters]")
     REQUIRE(p.granularFeedbackParam != nullptr);
     REQUIRE(p.granularWetDryParam != nullptr);
     REQUIRE(p.granularSpreadParam != nullptr);
+    REQUIRE(p.grainScatterParam != nullptr);
     REQUIRE(p.looperStateParam != nullptr);
     REQUIRE(p.signalChainParam != nullptr);
 }
@@ -91,12 +92,176 @@ TEST_CASE ("State save and restore", "[state]")
 TEST_CASE ("MIDI and tail length", "[midi][tail]")
 {
     PluginProcessor p;
-    REQUIRE_FALSE(p.acceptsMidi());
+    REQUIRE(p.acceptsMidi()); // MIDI controllers drive parameters
     REQUIRE_FALSE(p.producesMidi());
     REQUIRE_FALSE(p.isMidiEffect());
     REQUIRE(p.getTailLengthSeconds() >= 0.0);
 }
 
+TEST_CASE ("MIDI controllers take effect at their own sample", "[midi][processBlock]")
+{
+    PluginProcessor p;
+
+    // a long delay that hasn't come round yet, fully dry, so the output is
+    // exactly the input until the mix moves (kept under the output limiter's
+    // ceiling, so only its latency shows)
+    for (const auto& [id, value] : { std::pair<const char*, float> { "signalPath", 0.0f }, { "delayTime", 1.0f }, { "wetDry", 0.0f } })
+    {
+        auto* parameter = p.apvts.getParameter (id);
+        REQUIRE (parameter != nullptr);
+        parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+    }
+
+    p.prepareToPlay (48000.0, 2048);
+
+    juce::AudioBuffer<float> buffer (2, 2048);
+    juce::MidiBuffer midi;
+
+    constexpr float input = 0.5f;
+    const auto latency = p.getLatencySamples();
+    REQUIRE (latency > 0);
+
+    for (int block = 0; block < 4; ++block)
+    {
+        for (int channel = 0; channel < 2; ++channel)
+            juce::FloatVectorOperations::fill (buffer.getWritePointer (channel), input, 2048);
+        p.processBlock (buffer, midi);
+    }
+
+    // fully wet from sample 1000 (controller 22 is wetDry)
+    for (int channel = 0; channel < 2; ++channel)
+        juce::FloatVectorOperations::fill (buffer.getWritePointer (channel), input, 2048);
+    midi.addEvent (juce::MidiMessage::controllerEvent (1, 22, 127), 1000);
+    p.processBlock (buffer, midi);
+
+    // not a sample early, then ramping towards the (still silent) delay
+    CHECK (buffer.getSample (0, 999 + latency) == input);
+    CHECK (buffer.getSample (0, 1100 + latency) < 0.95f * input);
+    CHECK (buffer.getSample (1, 2047) < 0.05f * input);
+
+    p.releaseResources();
+}
+
+TEST_CASE ("Surround and ambisonic layouts are supported", "[buses]")
+{
+    PluginProcessor p;
+
+    for (const auto& set : { juce::AudioChannelSet::mono(),
+             juce::AudioChannelSet::stereo(),
+             juce::AudioChannelSet::create5point1(),
+             juce::AudioChannelSet::create7point1point4(),
+             juce::AudioChannelSet::ambisonic (3) })
+    {
+        INFO (set.getDescription());
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add (set);
+        layout.outputBuses.add (set);
+        CHECK (p.isBusesLayoutSupported (layout));
+    }
+
+    // the input has to match the output
+    juce::AudioProcessor::BusesLayout mismatched;
+    mismatched.inputBuses.add (juce::AudioChannelSet::stereo());
+    mismatched.outputBuses.add (juce::AudioChannelSet::create5point1());
+    CHECK_FALSE (p.isBusesLayoutSupported (mismatched));
+}
+
+TEST_CASE ("Every channel of a 7.1.4 layout is delayed", "[buses][processBlock]")
+{
+    PluginProcessor p;
+
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add (juce::AudioChannelSet::create7point1point4());
+    layout.outputBuses.add (juce::AudioChannelSet::create7point1point4());
+    REQUIRE (p.setBusesLayout (layout));
+
+    // a 10 ms fully wet delay on its own
+    for (const auto& [id, value] : { std::pair<const char*, float> { "signalPath", 0.0f }, { "delayTime", 0.01f }, { "wetDry", 1.0f } })
+    {
+        auto* parameter = p.apvts.getParameter (id);
+        REQUIRE (parameter != nullptr);
+        parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+    }
+
+    p.prepareToPlay (48000.0, 1024);
+
+    const auto numChannels = layout.getMainOutputChannels();
+    REQUIRE (numChannels == 12);
+    juce::AudioBuffer<float> buffer (numChannels, 1024);
+    juce::MidiBuffer midi;
+
+    // let the delay time and mix ramp to their values on silence
+    for (int block = 0; block < 8; ++block)
+    {
+        buffer.clear();
+        p.processBlock (buffer, midi);
+    }
+
+    // then an impulse on each channel, a channel apart in time (under the
+    // output limiter's ceiling, so only its latency shows)
+    buffer.clear();
+    for (int channel = 0; channel < numChannels; ++channel)
+        buffer.setSample (channel, channel, 0.5f);
+
+    p.processBlock (buffer, midi);
+
+    // each channel's impulse comes out of its own line 480 samples later,
+    // plus the limiter's latency
+    const auto latency = p.getLatencySamples();
+    REQUIRE (470 + numChannels + latency + 20 <= 1024);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        INFO ("channel " << channel);
+        CHECK (std::abs (buffer.getSample (channel, channel + latency)) < 1.0e-3f);
+        CHECK (buffer.getMagnitude (channel, 470 + channel + latency, 20) > 0.25f);
+    }
+
+    p.releaseResources();
+}
+
+TEST_CASE ("The reverb keeps 5.1 channels apart", "[buses][processBlock]")
+{
+    PluginProcessor p;
+
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add (juce::AudioChannelSet::create5point1());
+    layout.outputBuses.add (juce::AudioChannelSet::create5point1());
+    REQUIRE (p.setBusesLayout (layout));
+
+    auto* signalPath = p.apvts.getParameter ("signalPath");
+    REQUIRE (signalPath != nullptr);
+    signalPath->setValueNotifyingHost (signalPath->convertTo0to1 (static_cast<float> (SignalPathManager::ReverbOnly)));
+
+    p.prepareToPlay (48000.0, 1024);
+
+    const auto numChannels = layout.getMainOutputChannels();
+    const auto centre = juce::AudioChannelSet::create5point1().getChannelIndexForType (juce::AudioChannelSet::centre);
+    juce::AudioBuffer<float> buffer (numChannels, 1024);
+    juce::MidiBuffer midi;
+
+    // an impulse on the centre channel only rings there, nothing reaches the
+    // LFE or the speakers around it
+    buffer.clear();
+    buffer.setSample (centre, 0, 0.5f);
+
+    for (int block = 0; block < 8; ++block)
+    {
+        p.processBlock (buffer, midi);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            INFO ("block " << block << ", channel " << channel);
+            if (channel != centre)
+                REQUIRE (buffer.getMagnitude (channel, 0, 1024) == 0.0f);
+        }
+
+        buffer.clear();
+    }
+
+    p.releaseResources();
+}
+
 TEST_CASE ("Editor creation", "[editor]")
 {
     PluginProcessor p;
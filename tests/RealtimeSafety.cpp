@@ -0,0 +1,321 @@
+#include "helpers/realtime_guard.h"
+#include <PluginProcessor.h>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <cerrno>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+//==============================================================================
+// allocation and lock hooks
+//
+// On glibc we interpose the C allocator and pthread_mutex_lock directly, which
+// also catches allocations made behind our back by the standard library, JUCE
+// and the C runtime (std::function, juce::String, DBG, printf...). Everywhere
+// else we fall back to replacing the global operator new/delete, which covers
+// everything allocated from C++.
+
+#if defined(__GLIBC__)
+    #include <dlfcn.h>
+    #include <pthread.h>
+
+extern "C"
+{
+    void* __libc_malloc (size_t);
+    void* __libc_calloc (size_t, size_t);
+    void* __libc_realloc (void*, size_t);
+    void* __libc_memalign (size_t, size_t);
+    void __libc_free (void*);
+
+    void* malloc (size_t size)
+    {
+        realtime_guard::noteAllocation();
+        return __libc_malloc (size);
+    }
+
+    void* calloc (size_t count, size_t size)
+    {
+        realtime_guard::noteAllocation();
+        return __libc_calloc (count, size);
+    }
+
+    void* realloc (void* ptr, size_t size)
+    {
+        realtime_guard::noteAllocation();
+        return __libc_realloc (ptr, size);
+    }
+
+    void* memalign (size_t alignment, size_t size)
+    {
+        realtime_guard::noteAllocation();
+        return __libc_memalign (alignment, size);
+    }
+
+    void* aligned_alloc (size_t alignment, size_t size)
+    {
+        realtime_guard::noteAllocation();
+        return __libc_memalign (alignment, size);
+    }
+
+    int posix_memalign (void** result, size_t alignment, size_t size)
+    {
+        realtime_guard::noteAllocation();
+        if (alignment % sizeof (void*) != 0 || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+
+        *result = __libc_memalign (alignment, size);
+        return *result != nullptr || size == 0 ? 0 : ENOMEM;
+    }
+
+    void free (void* ptr)
+    {
+        if (ptr != nullptr)
+            realtime_guard::noteDeallocation();
+        __libc_free (ptr);
+    }
+
+    // the __pthread_* aliases are only exported as compat symbols, so the real
+    // functions are looked up lazily (a lock can be taken before static init)
+    using MutexFunction = int (*) (pthread_mutex_t*);
+
+    static MutexFunction lookupMutexFunction (const char* name)
+    {
+        return reinterpret_cast<MutexFunction> (dlsym (RTLD_NEXT, name));
+    }
+
+    int pthread_mutex_lock (pthread_mutex_t* mutex)
+    {
+        static const auto realLock = lookupMutexFunction ("pthread_mutex_lock");
+        realtime_guard::noteLock();
+        return realLock (mutex);
+    }
+
+    int pthread_mutex_trylock (pthread_mutex_t* mutex)
+    {
+        static const auto realTryLock = lookupMutexFunction ("pthread_mutex_trylock");
+        realtime_guard::noteLock();
+        return realTryLock (mutex);
+    }
+}
+
+static constexpr bool detectsLocks = true;
+
+#else
+
+void* operator new (std::size_t size)
+{
+    realtime_guard::noteAllocation();
+    if (auto* ptr = std::malloc (size == 0 ? 1 : size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)
+{
+    return ::operator new (size);
+}
+
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept
+{
+    realtime_guard::noteAllocation();
+    return std::malloc (size == 0 ? 1 : size);
+}
+
+void* operator new[] (std::size_t size, const std::nothrow_t& tag) noexcept
+{
+    return ::operator new (size, tag);
+}
+
+void operator delete (void* ptr) noexcept
+{
+    if (ptr != nullptr)
+        realtime_guard::noteDeallocation();
+    std::free (ptr);
+}
+
+void operator delete[] (void* ptr) noexcept { ::operator delete (ptr); }
+void operator delete (void* ptr, std::size_t) noexcept { ::operator delete (ptr); }
+void operator delete[] (void* ptr, std::size_t) noexcept { ::operator delete (ptr); }
+
+// the aligned overloads are left to the runtime: none of the processors use
+// over-aligned types, and a mismatched aligned free would be worse than a miss
+
+// locks can't be intercepted portably, so only allocations are checked here
+static constexpr bool detectsLocks = false;
+
+#endif
+
+//==============================================================================
+namespace
+{
+    constexpr int numProcessingModes = SignalPathManager::SendReturn + 1;
+
+    constexpr double testSampleRate = 48000.0;
+    constexpr int maxTestBlockSize = 1024;
+
+    void setParameter (PluginProcessor& plugin, const juce::String& id, float value)
+    {
+        auto* parameter = plugin.apvts.getParameter (id);
+        REQUIRE (parameter != nullptr);
+        parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+    }
+
+    void fillWithTestSignal (juce::AudioBuffer<float>& buffer, juce::Random& random)
+    {
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        {
+            auto* data = buffer.getWritePointer (channel);
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                data[i] = random.nextFloat() - 0.5f;
+        }
+    }
+
+    // runs a few blocks of the given size through processBlock, each inside a
+    // RealtimeScope, and returns after checking nothing was counted
+    void processGuardedBlocks (PluginProcessor& plugin, int blockSize, int numBlocks, juce::Random& random)
+    {
+        // everything that may allocate happens outside the guarded scope
+        juce::AudioBuffer<float> buffer (2, blockSize);
+        juce::MidiBuffer midi;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            fillWithTestSignal (buffer, random);
+
+            realtime_guard::resetViolations();
+            {
+                realtime_guard::RealtimeScope scope;
+                plugin.processBlock (buffer, midi);
+            }
+
+            INFO ("block size " << blockSize << ", block " << block);
+            CHECK (realtime_guard::allocations() == 0);
+            CHECK (realtime_guard::deallocations() == 0);
+            if constexpr (detectsLocks)
+                CHECK (realtime_guard::locks() == 0);
+        }
+    }
+}
+
+TEST_CASE ("Real-time guard counts only inside a scope", "[realtime]")
+{
+    realtime_guard::resetViolations();
+    // explicit calls, since new-expressions may legally be optimised away
+    ::operator delete (::operator new (sizeof (int)));
+    REQUIRE (realtime_guard::allocations() == 0);
+
+    {
+        realtime_guard::RealtimeScope scope;
+        ::operator delete (::operator new (sizeof (int)));
+    }
+    REQUIRE (realtime_guard::allocations() == 1);
+    REQUIRE (realtime_guard::deallocations() == 1);
+
+    if constexpr (detectsLocks)
+    {
+        std::mutex mutex;
+        realtime_guard::resetViolations();
+        {
+            realtime_guard::RealtimeScope scope;
+            const std::scoped_lock lock (mutex);
+        }
+        REQUIRE (realtime_guard::locks() == 1);
+    }
+}
+
+TEST_CASE ("processBlock neither allocates nor locks", "[realtime][processBlock]")
+{
+    const auto mode = GENERATE (range (0, numProcessingModes));
+    const auto blockSize = GENERATE (32, 64, 512, 997, maxTestBlockSize);
+
+    PluginProcessor plugin;
+    setParameter (plugin, "signalPath", static_cast<float> (mode));
+    plugin.prepareToPlay (testSampleRate, maxTestBlockSize);
+
+    juce::Random random (mode * 7919 + blockSize);
+
+    INFO ("processing mode " << mode);
+
+    SECTION ("default parameters")
+    {
+        processGuardedBlocks (plugin, blockSize, 8, random);
+    }
+
+    SECTION ("parameter changes between blocks")
+    {
+        // every change is made from the "message thread" side, then the next
+        // block has to pick it up without allocating
+        for (int round = 0; round < 4; ++round)
+        {
+            setParameter (plugin, "delayTime", 0.05f + 0.3f * random.nextFloat());
+            setParameter (plugin, "feedback", random.nextFloat() * 0.9f);
+            setParameter (plugin, "reverbRoomSize", random.nextFloat());
+            setParameter (plugin, "reverbTone", 1000.0f + 19000.0f * random.nextFloat());
+            setParameter (plugin, "grainSize", 0.01f + 0.5f * random.nextFloat());
+            setParameter (plugin, "grainDensity", 0.5f + 9.5f * random.nextFloat());
+            setParameter (plugin, "pitchShift", 0.5f + 1.5f * random.nextFloat());
+            setParameter (plugin, "grainWindow", static_cast<float> (round % 5));
+            setParameter (plugin, "grainQuality", static_cast<float> (round % 4));
+
+            processGuardedBlocks (plugin, blockSize, 2, random);
+        }
+    }
+
+    plugin.releaseResources();
+}
+
+TEST_CASE ("Processing mode changes neither allocate nor lock", "[realtime][signalPath]")
+{
+    PluginProcessor plugin;
+    setParameter (plugin, "signalPath", static_cast<float> (SignalPathManager::DelayOnly));
+    plugin.prepareToPlay (testSampleRate, maxTestBlockSize);
+
+    juce::Random random (1234);
+
+    // the new mode's processors are prepared on the warm-up thread, so the
+    // audio thread keeps running the old mode until they're ready, both
+    // straight after the change and once they've had time to warm up
+    for (int mode = 0; mode < numProcessingModes * 2; ++mode)
+    {
+        INFO ("processing mode " << mode % numProcessingModes);
+        setParameter (plugin, "signalPath", static_cast<float> (mode % numProcessingModes));
+        processGuardedBlocks (plugin, 512, 2, random);
+
+        juce::Thread::sleep (100);
+        processGuardedBlocks (plugin, 512, 2, random);
+    }
+
+    plugin.releaseResources();
+}
+
+TEST_CASE ("Looper state changes neither allocate nor lock", "[realtime][looper]")
+{
+    const auto blockSize = GENERATE (32, 512, maxTestBlockSize);
+
+    PluginProcessor plugin;
+    setParameter (plugin, "signalPath", static_cast<float> (SignalPathManager::LooperOnly));
+    plugin.prepareToPlay (testSampleRate, maxTestBlockSize);
+
+    juce::Random random (blockSize);
+
+    // walk through every transition the looper UI can produce, including
+    // repeated clears and clearing an empty loop
+    using State = LooperProcessor::State;
+    const State sequence[] = {
+        State::Clear, State::Recording, State::Playing, State::Overdubbing,
+        State::Playing, State::Stopped, State::Playing, State::Clear,
+        State::Clear, State::Recording, State::Stopped, State::Overdubbing,
+        State::Clear
+    };
+
+    for (const auto state : sequence)
+    {
+        INFO ("looper state " << static_cast<int> (state));
+        setParameter (plugin, "looperState", static_cast<float> (state));
+        processGuardedBlocks (plugin, blockSize, 6, random);
+    }
+
+    plugin.releaseResources();
+}
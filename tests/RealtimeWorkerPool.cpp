@@ -0,0 +1,44 @@
+#include <AudioDSP/DSPHelpers/RealtimeWorkerPool/RealtimeWorkerPool.h>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <array>
+#include <atomic>
+
+namespace
+{
+    struct Batch
+    {
+        std::array<std::atomic<int>, 16> runs {};
+    };
+
+    void countRun (void* context, int index)
+    {
+        static_cast<Batch*> (context)->runs[static_cast<size_t> (index)].fetch_add (1);
+    }
+}
+
+TEST_CASE ("Worker pool runs every job of a batch exactly once", "[workers]")
+{
+    auto numWorkers = GENERATE (0, 1, 3);
+    RealtimeWorkerPool workers (numWorkers, false);
+    // a system that won't give us real-time threads gets no workers, and the
+    // caller runs every job
+    CHECK ((workers.getNumWorkers() == numWorkers || workers.getNumWorkers() == 0));
+
+    for (int round = 0; round < 2000; ++round)
+    {
+        const auto numJobs = 1 + round % 16;
+
+        Batch batch;
+        workers.run (countRun, &batch, numJobs);
+
+        // run() only returns once every job is done, and no job runs twice
+        for (int index = 0; index < 16; ++index)
+            REQUIRE (batch.runs[static_cast<size_t> (index)].load() == (index < numJobs ? 1 : 0));
+
+        // let the workers fall asleep now and then, so waking them is tested too
+        if (round % 500 == 499)
+            juce::Thread::sleep (20);
+    }
+}
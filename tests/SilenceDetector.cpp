@@ -0,0 +1,68 @@
+#include <AudioDSP/DSPHelpers/SilenceDetector/SilenceDetector.h>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+
+namespace
+{
+    constexpr int blockSize = 64;
+
+    // run one block of constant input through the detector, with a processor
+    // that rings for tailSamples after any input
+    SilenceDetector::State runBlock (SilenceDetector& detector, juce::AudioBuffer<float>& buffer, float input, juce::int64 tailSamples)
+    {
+        juce::FloatVectorOperations::fill (buffer.getWritePointer (0), input, blockSize);
+        juce::dsp::AudioBlock<float> block (buffer);
+
+        return detector.process (block, [tailSamples] (float) { return tailSamples; });
+    }
+}
+
+TEST_CASE ("Detector sleeps once the input and the tail have gone silent", "[silence]")
+{
+    SilenceDetector detector;
+    juce::AudioBuffer<float> buffer (1, blockSize);
+
+    // nothing has come in yet, so there's nothing to ring out
+    CHECK (detector.isAsleep());
+    CHECK (runBlock (detector, buffer, 0.0f, 4 * blockSize) == SilenceDetector::asleep);
+
+    // input wakes it, even negative input
+    CHECK (runBlock (detector, buffer, -0.5f, 4 * blockSize) == SilenceDetector::awake);
+    CHECK_FALSE (detector.isAsleep());
+
+    // the tail keeps it awake for as long as the processor says
+    for (int i = 0; i < 4; ++i)
+        CHECK (runBlock (detector, buffer, 0.0f, 4 * blockSize) == SilenceDetector::awake);
+
+    // then it falls asleep once, and stays asleep
+    CHECK (runBlock (detector, buffer, 0.0f, 4 * blockSize) == SilenceDetector::fallingAsleep);
+    CHECK (runBlock (detector, buffer, 0.0f, 4 * blockSize) == SilenceDetector::asleep);
+    CHECK (detector.isAsleep());
+
+    // input below the silence level doesn't wake it
+    CHECK (runBlock (detector, buffer, SilenceDetector::silenceLevel * 0.5f, 4 * blockSize) == SilenceDetector::asleep);
+
+    // an endless tail never sleeps
+    CHECK (runBlock (detector, buffer, 1.0f, SilenceDetector::endlessTail) == SilenceDetector::awake);
+    for (int i = 0; i < 100; ++i)
+        REQUIRE (runBlock (detector, buffer, 0.0f, SilenceDetector::endlessTail) == SilenceDetector::awake);
+
+    // and reset forgets it
+    detector.reset();
+    CHECK (runBlock (detector, buffer, 0.0f, SilenceDetector::endlessTail) == SilenceDetector::asleep);
+}
+
+TEST_CASE ("Decay times follow the feedback gain", "[silence]")
+{
+    // already silent, or no feedback at all
+    CHECK (SilenceDetector::getDecaySamples (SilenceDetector::silenceLevel * 0.5f, 0.5f, 100.0) == 0);
+    CHECK (SilenceDetector::getDecaySamples (1.0f, 0.0f, 100.0) == 0);
+
+    // halving every step takes 17 steps to get from 1 to below -100 dB
+    CHECK (SilenceDetector::getDecaySamples (1.0f, 0.5f, 100.0) == 1700);
+
+    // full feedback never decays, and is reported as the longest tail
+    CHECK (SilenceDetector::getDecaySamples (1.0f, 1.0f, 100.0) == SilenceDetector::endlessTail);
+    CHECK (SilenceDetector::toSeconds (SilenceDetector::endlessTail, 48000.0) == SilenceDetector::longestTailSeconds);
+    CHECK_THAT (SilenceDetector::toSeconds (24000, 48000.0), Catch::Matchers::WithinAbs (0.5, 1.0e-9));
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+/* Real-time safety detector used by RealtimeSafety.cpp.
+ *
+ * A RealtimeScope marks the current thread as "inside the audio callback".
+ * While a scope is open, the hooks installed in RealtimeSafety.cpp count every
+ * heap allocation/free and every mutex lock taken on that thread, so a test
+ * can wrap processBlock in a scope and REQUIRE that nothing was counted.
+ *
+ * Only the counting state lives here; the hooks themselves (global operator
+ * new/delete, and on glibc also malloc/free and pthread_mutex_lock) have to be
+ * defined exactly once, in the test translation unit.
+ *
+ * Example usage
+ *
+  realtime_guard::resetViolations();
+  {
+      realtime_guard::RealtimeScope scope;
+      plugin.processBlock (buffer, midi);
+  }
+  REQUIRE (realtime_guard::allocations() == 0);
+  REQUIRE (realtime_guard::locks() == 0);
+
+ */
+namespace realtime_guard
+{
+    // true while the current thread is inside a RealtimeScope
+    inline thread_local bool inRealtimeScope = false;
+
+    inline std::atomic<size_t> allocationCount { 0 };
+    inline std::atomic<size_t> deallocationCount { 0 };
+    inline std::atomic<size_t> lockCount { 0 };
+
+    // called from the hooks, so these must not allocate or lock themselves
+    inline void noteAllocation()   { if (inRealtimeScope) allocationCount.fetch_add (1, std::memory_order_relaxed); }
+    inline void noteDeallocation() { if (inRealtimeScope) deallocationCount.fetch_add (1, std::memory_order_relaxed); }
+    inline void noteLock()         { if (inRealtimeScope) lockCount.fetch_add (1, std::memory_order_relaxed); }
+
+    [[maybe_unused]] static size_t allocations()   { return allocationCount.load(); }
+    [[maybe_unused]] static size_t deallocations() { return deallocationCount.load(); }
+    [[maybe_unused]] static size_t locks()         { return lockCount.load(); }
+
+    [[maybe_unused]] static void resetViolations()
+    {
+        allocationCount = 0;
+        deallocationCount = 0;
+        lockCount = 0;
+    }
+
+    // RAII marker for the audio callback; scopes may nest
+    struct RealtimeScope
+    {
+        RealtimeScope() : previous (inRealtimeScope) { inRealtimeScope = true; }
+        ~RealtimeScope() { inRealtimeScope = previous; }
+
+        RealtimeScope (const RealtimeScope&) = delete;
+        RealtimeScope& operator= (const RealtimeScope&) = delete;
+
+        const bool previous;
+    };
+}